@@ -7,6 +7,7 @@
 #include <vector>
 
 #include "../../common/inc/memorymap.hpp"
+#include "../../common/inc/symbols.hpp"
 #include "parser.hpp"
 #include "instruction.hpp"
 
@@ -37,8 +38,6 @@ private:
     std::vector<Placeholder> program;
     std::optional<size_t> next_fixed_address;
 
-    bool try_assemble_pass();
-
 public:
     Program();
 
@@ -47,5 +46,12 @@ public:
     void add_instruction(std::vector<std::unique_ptr<Token>>&& args);
     void add_label(std::string&& value, Origin origin);
 
+    // assemble() is try_assemble_pass() until one succeeds, then output()
     MemoryMap assemble();
+    // one layout and encoding pass, returns false if an instruction had to grow and another pass is needed
+    bool try_assemble_pass();
+    // the encoded program, valid after a successful pass
+    MemoryMap output() const;
+    // label addresses, valid after assemble()
+    SymbolTable symbols() const;
 };
\ No newline at end of file
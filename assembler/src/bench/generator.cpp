@@ -0,0 +1,127 @@
+#include "generator.hpp"
+
+#include <algorithm>
+#include <format>
+#include <utility>
+
+static constexpr size_t FUNCTION_MIN = 16; // instructions
+static constexpr size_t FUNCTION_MAX = 64;
+static constexpr size_t LOCAL_SPACING = 6; // instructions between local labels
+static constexpr size_t DATA_SPACING = 8; // functions between data blocks
+
+static constexpr const char* DATA_REGISTERS[] { "ga", "gb", "gc", "gd", "ge.l", "ge.h", "gf.l", "gf.h", "gg.l", "gg.h" };
+static constexpr const char* POINTER_REGISTERS[] { "ge", "gf", "gg" }; // gh is left for the pseudo instructions
+static constexpr const char* ALU_OPS[] { "add", "adc", "sub", "sbc", "cmp", "and", "or", "xor", "mov" };
+static constexpr const char* IMMEDIATE_OPS[] { "add", "sub", "cmp", "and", "or", "xor" };
+static constexpr const char* SHIFT_OPS[] { "shl", "shr", "asr" };
+static constexpr const char* CONDITIONS[] { "z", "nz", "c", "nc", "n", "lt", "gte", "ltu", "gtu" };
+static constexpr const char* WORDS[] { "the", "quick", "brown", "fox", "jumps", "over", "lazy", "dog" };
+
+SourceGenerator::SourceGenerator(uint32_t seed) :
+    _random(seed),
+    _functions(0),
+    _data_blocks(0)
+{}
+
+size_t SourceGenerator::_uniform(size_t min, size_t max) {
+    return std::uniform_int_distribution<size_t>(min, max)(_random);
+}
+
+void SourceGenerator::_line(const std::string& line) {
+    _source.text += "    ";
+    _source.text += line;
+    _source.text += '\n';
+}
+
+void SourceGenerator::_label(const std::string& label) {
+    _source.text += label;
+    _source.text += ":\n";
+    ++_source.labels;
+}
+
+void SourceGenerator::_instruction(size_t function, size_t local, size_t locals) {
+    ++_source.instructions;
+    const size_t kind = _uniform(0, 99);
+    if (kind < 40) {
+        _line(std::format("{} {} {}", _pick(ALU_OPS), _pick(DATA_REGISTERS), _pick(DATA_REGISTERS)));
+    } else if (kind < 50) {
+        _line(std::format("{} {} {}", _pick(IMMEDIATE_OPS), _pick(DATA_REGISTERS), static_cast<int>(_uniform(0, 63)) - 32));
+    } else if (kind < 55) {
+        _line(std::format("{} {} {}", _pick(SHIFT_OPS), _pick(DATA_REGISTERS), _uniform(1, 7)));
+    } else if (kind < 60) {
+        _line(std::format("*mov {} {}", _pick(DATA_REGISTERS), _uniform(0, 255)));
+    } else if (kind < 63) {
+        _line(std::format("*mov {} {:#06x}", _pick(POINTER_REGISTERS), _uniform(0, 0xFFFF)));
+    } else if (kind < 75) {
+        const char* op = _uniform(0, 1) ? "ld" : "st";
+        _line(std::format("{} {} {} {}", op, _pick(DATA_REGISTERS), _pick(POINTER_REGISTERS), static_cast<int>(_uniform(0, 63)) - 32));
+    } else if (kind < 87) {
+        // a branch to the local label before or after this one, usually in reach of rjmp
+        const size_t target = _uniform(0, 1) ? (local == 0 ? 0 : local - 1) : std::min(local + 1, locals - 1);
+        _line(std::format("*jmp {} f{}_{} gh", _pick(CONDITIONS), function, target));
+    } else if (kind < 93) {
+        _line(std::format("*call f{} gh", _uniform(0, _functions - 1)));
+    } else if (kind < 96) {
+        _line(std::format("*jmp f{}_0 gh", _uniform(0, _functions - 1)));
+    } else if (_data_blocks != 0) {
+        _line(std::format("*mov {} d{}", _pick(POINTER_REGISTERS), _uniform(0, _data_blocks - 1)));
+    } else {
+        _line(std::format("*mov {} f{}", _pick(POINTER_REGISTERS), _uniform(0, _functions - 1)));
+    }
+}
+
+void SourceGenerator::_function(size_t function) {
+    const size_t instructions = _uniform(FUNCTION_MIN, FUNCTION_MAX);
+    const size_t locals = (instructions + LOCAL_SPACING - 1) / LOCAL_SPACING;
+    _label(std::format("f{}", function));
+    for (size_t i = 0; i < instructions; ++i) {
+        if (i % LOCAL_SPACING == 0)
+            _label(std::format("f{}_{}", function, i / LOCAL_SPACING));
+        _instruction(function, i / LOCAL_SPACING, locals);
+    }
+    _line("ret");
+    ++_source.instructions;
+}
+
+void SourceGenerator::_data(size_t block) {
+    _label(std::format("d{}", block));
+    switch (_uniform(0, 2)) {
+    case 0: {
+        const size_t size = _uniform(32, 256);
+        _line(std::format(".bytes {} {}", size, _uniform(0, 255)));
+        _source.data_bytes += size;
+        break;
+    }
+    case 1: {
+        std::string line = ".byte";
+        const size_t size = _uniform(8, 32);
+        for (size_t i = 0; i < size; ++i)
+            line += std::format(" {}", _uniform(0, 255));
+        _line(line);
+        _source.data_bytes += size;
+        break;
+    }
+    default: {
+        std::string text;
+        for (size_t i = _uniform(2, 8); i != 0; --i)
+            text += std::string(text.empty() ? "" : " ") + _pick(WORDS);
+        _line(std::format(".byte \"{}\" 0", text));
+        _source.data_bytes += text.size() + 1;
+        break;
+    }
+    }
+}
+
+SourceGenerator::Source SourceGenerator::generate(size_t instructions) {
+    _source = {};
+    _functions = std::max<size_t>(1, instructions / ((FUNCTION_MIN + FUNCTION_MAX) / 2 + 1));
+    _data_blocks = _functions / DATA_SPACING;
+
+    _source.text += std::format("# synthetic source: about {} instructions in {} functions\n\n", instructions, _functions);
+    for (size_t function = 0; function < _functions; ++function) {
+        _function(function);
+        if ((function + 1) % DATA_SPACING == 0)
+            _data(function / DATA_SPACING);
+    }
+    return std::move(_source);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+// Generates large synthetic sources for benchmarking the assembler. The result reads like a real
+// program: functions of ALU, load and store instructions with local labels and short branches
+// between them, calls and jumps to other functions anywhere in the source (so forward references
+// that the assembler must relax from the short to the long encodings), label addresses loaded
+// into registers, and data blocks of .bytes fills, byte lists and strings between the functions.
+class SourceGenerator {
+public:
+    struct Source {
+        std::string text;
+        size_t instructions = 0;
+        size_t labels = 0;
+        size_t data_bytes = 0;
+    };
+
+private:
+    std::mt19937 _random;
+    Source _source;
+    size_t _functions;
+    size_t _data_blocks;
+
+    size_t _uniform(size_t min, size_t max);
+    template <size_t N>
+    const char* _pick(const char* const (&values)[N]) {
+        return values[_uniform(0, N - 1)];
+    }
+
+    void _line(const std::string& line);
+    void _label(const std::string& label);
+    void _instruction(size_t function, size_t local, size_t locals);
+    void _function(size_t function);
+    void _data(size_t block);
+
+public:
+    explicit SourceGenerator(uint32_t seed = 1);
+
+    // about the given number of instructions, the same source for the same seed
+    Source generate(size_t instructions);
+};
@@ -0,0 +1,152 @@
+#include "../../inc/parser.hpp"
+#include "../../inc/program.hpp"
+#include "../../../common/inc/bench.hpp"
+#include "generator.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Assembler throughput benchmark (make bench): generates synthetic sources of increasing size and
+// times parse(), the assembly passes and writing the output separately, printing a table to stderr
+// and the results as JSON to stdout or a file.
+
+static constexpr size_t SIZES[] { 1000, 4000, 16000 }; // instructions, the largest about as much as fits the address space
+
+namespace {
+
+using clock = std::chrono::steady_clock;
+
+double nanoseconds_since(clock::time_point begin) {
+    return std::chrono::duration<double, std::nano>(clock::now() - begin).count();
+}
+
+// time every phase of assembling one source, samples times
+bool bench_source(Bench& bench, const std::string& name, const SourceGenerator::Source& source, size_t samples) {
+    const std::string output_filename = (std::filesystem::temp_directory_path() / "assembler_bench.bin").string();
+
+    std::vector<double> parse_times, assemble_times, output_times, write_times;
+    uint64_t passes = 0;
+    size_t size = 0;
+    // the first run is a warmup
+    for (size_t i = 0; i <= samples; ++i) {
+        auto begin = clock::now();
+        Program program = parse(source.text);
+        const double parse_time = nanoseconds_since(begin);
+
+        begin = clock::now();
+        passes = 1;
+        while (!program.try_assemble_pass())
+            ++passes;
+        const double assemble_time = nanoseconds_since(begin);
+
+        begin = clock::now();
+        const MemoryMap map = program.output();
+        const double output_time = nanoseconds_since(begin);
+
+        begin = clock::now();
+        map.write(output_filename);
+        const double write_time = nanoseconds_since(begin);
+
+        size = 0;
+        for (const auto& [address, data]: map)
+            size = std::max(size, address + data.size());
+        if (i == 0)
+            continue;
+        parse_times.push_back(parse_time);
+        assemble_times.push_back(assemble_time);
+        output_times.push_back(output_time);
+        write_times.push_back(write_time);
+    }
+    std::filesystem::remove(output_filename);
+
+    if (bench.selected(name + "/parse")) {
+        bench.record(name + "/parse", "source", 1, parse_times);
+        bench.metric("source_kb", source.text.size() / 1024.0);
+        bench.metric("ns_per_line", bench.results().back().median / (source.instructions + source.labels));
+    }
+    if (bench.selected(name + "/assemble")) {
+        bench.record(name + "/assemble", "source", 1, assemble_times);
+        bench.metric("passes", passes);
+        bench.metric("us_per_pass", bench.results().back().median / passes / 1e3);
+    }
+    if (bench.selected(name + "/output")) {
+        bench.record(name + "/output", "source", 1, output_times);
+        bench.metric("bytes", size);
+    }
+    if (bench.selected(name + "/write")) {
+        bench.record(name + "/write", "source", 1, write_times);
+        bench.metric("bytes", size);
+    }
+
+    if (size > 0x10000) {
+        std::cerr << std::format("{}: output of {} bytes does not fit the address space\n", name, size);
+        return false;
+    }
+    return true;
+}
+
+}
+
+int main(int argc, const char* argv[]) {
+    Bench::Options options;
+    options.samples = 5; // the largest source takes seconds to assemble
+    std::vector<size_t> sizes(std::begin(SIZES), std::end(SIZES));
+    std::optional<std::string> output_filename;
+    uint32_t seed = 1;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--samples" && has_value) {
+            options.samples = std::stoul(argv[++i]);
+        } else if (arg == "--filter" && has_value) {
+            options.filter = argv[++i];
+        } else if (arg == "--output" && has_value) {
+            output_filename = argv[++i];
+        } else if (arg == "--size" && has_value) {
+            sizes = { std::stoul(argv[++i]) };
+        } else if (arg == "--seed" && has_value) {
+            seed = std::stoul(argv[++i]);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--samples n] [--filter name] [--output json file] [--size instructions] [--seed n]\n";
+            return EINVAL;
+        }
+    }
+    if (options.samples == 0) {
+        std::cerr << "Sample count must be nonzero.\n";
+        return EINVAL;
+    }
+
+    Bench bench(options);
+    bool passed = true;
+    for (const size_t size: sizes) {
+        const std::string name = std::format("assembler/{}", size);
+        if (!bench.selected(name + "/parse") && !bench.selected(name + "/assemble") && !bench.selected(name + "/output") && !bench.selected(name + "/write"))
+            continue;
+        const SourceGenerator::Source source = SourceGenerator(seed).generate(size);
+        try {
+            passed &= bench_source(bench, name, source, options.samples);
+        } catch (const AssemblerError& error) {
+            std::cerr << std::format("{}: {}\n", name, error.what());
+            passed = false;
+        }
+    }
+
+    bench.write_table(std::cerr);
+
+    if (output_filename) {
+        std::ofstream file(*output_filename);
+        bench.write_json(file);
+    } else {
+        bench.write_json(std::cout);
+    }
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
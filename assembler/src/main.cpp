@@ -54,11 +54,13 @@ void print_origin(const std::string& str, Origin origin) {
 int main(int argc, const char* argv[]) {
     std::optional<std::string> input_filename;
     std::optional<std::string> output_filename;
+    std::optional<std::string> symbols_filename;
 
     enum class NextArg {
         NONE,
         INPUT_FILENAME,
         OUTPUT_FILENAME,
+        SYMBOLS_FILENAME,
     };
 
     NextArg next_arg = NextArg::NONE;
@@ -70,6 +72,8 @@ int main(int argc, const char* argv[]) {
             next_arg = NextArg::OUTPUT_FILENAME;
         else if (arg == "-i" || arg == "--input")
             next_arg = NextArg::INPUT_FILENAME;
+        else if (arg == "-s" || arg == "--symbols")
+            next_arg = NextArg::SYMBOLS_FILENAME;
         else { 
             switch (next_arg) {
             case NextArg::INPUT_FILENAME:
@@ -86,6 +90,13 @@ int main(int argc, const char* argv[]) {
                 }
                 output_filename = arg;
                 break;
+            case NextArg::SYMBOLS_FILENAME:
+                if (symbols_filename) {
+                    std::cerr << "Error: symbols filename already specified.\n";
+                    return EINVAL;
+                }
+                symbols_filename = arg;
+                break;
             default:
                 std::cerr << "Warning: unknown argument \"" << arg << "\".\n";
                 break;
@@ -108,6 +119,8 @@ int main(int argc, const char* argv[]) {
         Program program = parse(file);
         const MemoryMap output = program.assemble();
         output.write(*output_filename);
+        if (symbols_filename)
+            program.symbols().write(*symbols_filename);
     } catch (const AssemblerError& error) {
         print_origin(file, error.origin);
         std::cout << error.what() << '\n';
@@ -174,14 +174,28 @@ MemoryMap Program::assemble() {
             break;
     }
 
+    std::cout << "Passes: " << pass_count << '\n';
+
+    return output();
+}
+
+MemoryMap Program::output() const {
     MemoryMap output;
     for (size_t i = 0; i < program.size(); ++i) {
         if (program[i].tentative_address != output.curr_addr())
             output.set_address(program[i].tentative_address);
         output.append(program[i].last_output.begin(), program[i].last_output.end());
     }
+    return output;
+}
 
-    std::cout << "Passes: " << pass_count << '\n';
+SymbolTable Program::symbols() const {
+    size_t end = 0;
+    if (!program.empty())
+        end = program.back().tentative_address + program.back().tentative_size();
 
-    return output;
-}
\ No newline at end of file
+    SymbolTable table;
+    for (const auto& [label, index]: labels)
+        table.add(index == program.size() ? end : program[index].tentative_address, label);
+    return table;
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <format>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Microbenchmark harness. A benchmark body runs a given number of operations; the harness warms it
+// up while finding a batch size that takes about sample_seconds, then times a number of batches and
+// reports the median, mean, standard deviation and minimum nanoseconds per operation.
+class Bench {
+public:
+    struct Options {
+        size_t samples = 15;
+        double warmup_seconds = 0.05;
+        double sample_seconds = 0.01;
+        std::string filter; // only run benchmarks whose name contains it
+    };
+
+    struct Result {
+        std::string name;
+        std::string unit; // what an operation is
+        uint64_t operations; // per sample
+        size_t samples;
+        double median;
+        double mean;
+        double stddev;
+        double min;
+        std::vector<std::pair<std::string, double>> metrics; // extra figures derived from the timing
+    };
+
+private:
+    Options _options;
+    std::vector<Result> _results;
+
+public:
+    explicit Bench(const Options& options) :
+        _options(options)
+    {}
+
+    // keep the compiler from optimizing away a value
+    template <typename T>
+    static void keep(const T& value) {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    bool selected(const std::string& name) const {
+        return name.find(_options.filter) != std::string::npos;
+    }
+
+    // body(n) runs n operations, returns false if the benchmark isn't selected
+    template <typename F>
+    bool run(const std::string& name, const std::string& unit, F&& body) {
+        using clock = std::chrono::steady_clock;
+        if (!selected(name))
+            return false;
+
+        const auto time = [&body] (uint64_t n) {
+            const auto begin = clock::now();
+            body(n);
+            return std::chrono::duration<double>(clock::now() - begin).count();
+        };
+
+        // warm up, doubling the batch until one takes long enough to time
+        uint64_t n = 1;
+        double elapsed = 0;
+        const auto warmup_end = clock::now() + std::chrono::duration<double>(_options.warmup_seconds);
+        for (;;) {
+            const double seconds = time(n);
+            if (seconds >= _options.sample_seconds) {
+                elapsed = seconds;
+                if (clock::now() >= warmup_end)
+                    break;
+            } else {
+                n *= 2;
+            }
+        }
+        n = std::max<uint64_t>(1, n * _options.sample_seconds / elapsed);
+
+        std::vector<double> samples;
+        for (size_t i = 0; i < _options.samples; ++i)
+            samples.push_back(time(n) * 1e9 / n);
+        record(name, unit, n, std::move(samples));
+        return true;
+    }
+
+    // add a result timed by the caller, samples are nanoseconds per operation
+    void record(const std::string& name, const std::string& unit, uint64_t operations, std::vector<double> samples) {
+        std::sort(samples.begin(), samples.end());
+
+        Result result { name, unit, operations, samples.size(), 0, 0, 0, samples.front(), {} };
+        const size_t middle = samples.size() / 2;
+        result.median = samples.size() % 2 ? samples[middle] : (samples[middle - 1] + samples[middle]) / 2;
+        for (const double sample: samples)
+            result.mean += sample / samples.size();
+        for (const double sample: samples)
+            result.stddev += (sample - result.mean) * (sample - result.mean) / samples.size();
+        result.stddev = std::sqrt(result.stddev);
+        _results.push_back(result);
+    }
+
+    // add a figure to the last result
+    void metric(const std::string& name, double value) {
+        _results.back().metrics.emplace_back(name, value);
+    }
+
+    const std::vector<Result>& results() const {
+        return _results;
+    }
+
+    // a table of the results so far, for people
+    void write_table(std::ostream& out) const {
+        out << std::format("{:<40} {:>10} {:>10} {:>8}\n", "benchmark", "median ns", "min ns", "stddev");
+        for (const Result& r: _results) {
+            out << std::format("{:<40} {:>10.2f} {:>10.2f} {:>7.1f}%  per {}",
+                r.name, r.median, r.min, 100 * r.stddev / r.mean, r.unit);
+            for (const auto& [metric, value]: r.metrics)
+                out << std::format("  {} {:.2f}", metric, value);
+            out << '\n';
+        }
+    }
+
+    void write_json(std::ostream& out) const {
+        out << "{\n  \"unit\": \"ns\",\n  \"benchmarks\": [";
+        for (size_t i = 0; i < _results.size(); ++i) {
+            const Result& r = _results[i];
+            out << (i != 0 ? ",\n" : "\n");
+            out << std::format("    {{\"name\": \"{}\", \"per\": \"{}\", \"median\": {:.3f}, \"mean\": {:.3f}, \"stddev\": {:.3f}, \"min\": {:.3f}, \"samples\": {}, \"operations\": {}",
+                r.name, r.unit, r.median, r.mean, r.stddev, r.min, r.samples, r.operations);
+            for (const auto& [metric, value]: r.metrics)
+                out << std::format(", \"{}\": {:.3f}", metric, value);
+            out << "}";
+        }
+        out << "\n  ]\n}\n";
+    }
+};
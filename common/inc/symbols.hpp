@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+
+// Label addresses written by the assembler (--symbols), one "<hex address> <label>" per line.
+class SymbolTable {
+private:
+    std::multimap<size_t, std::string> _symbols;
+
+public:
+    using const_iterator = decltype(_symbols)::const_iterator;
+
+    struct Location {
+        const std::string* label;
+        size_t offset;
+    };
+
+    const_iterator begin() const;
+    const_iterator end() const;
+    bool empty() const;
+
+    void add(size_t address, const std::string& label);
+    // the closest label at or before address
+    std::optional<Location> find(size_t address) const;
+    // "label+0x4", or the hex address if there's no label before it
+    std::string format(size_t address) const;
+
+    void write(const std::string& filename) const;
+    // throws std::runtime_error if the file can't be read or a line is malformed
+    void read(const std::string& filename);
+};
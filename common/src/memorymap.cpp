@@ -1,6 +1,5 @@
 #include "../inc/memorymap.hpp"
 #include <fstream>
-#include <iostream>
 #include <limits>
 #include <stdexcept>
 #include <string>
@@ -61,12 +60,19 @@ void MemoryMap::write(const std::string& filename) const {
 
 void MemoryMap::read(const std::string& filename) {
     std::ifstream file(filename, file.binary);
+    if (!file)
+        throw std::runtime_error("MemoryMap: cannot open " + filename);
+    file.seekg(0, file.end);
+    const size_t file_size = file.tellg();
+    file.seekg(0, file.beg);
     for (;;) {
         const size_t address = bin_read<uint64_t>(file);
         const size_t size = bin_read<uint64_t>(file);
         if (file.eof())
             break;
-        std::cout << "address: " << address << ", bytes: " << size << '\n';
+        // a section longer than the rest of the file is a truncated or foreign file
+        if (!file || size > file_size - static_cast<size_t>(file.tellg()))
+            throw std::runtime_error("MemoryMap: truncated file " + filename);
         set_address(address);
         _curr->second.resize(size);
         file.read(reinterpret_cast<char*>(_curr->second.data()), size);
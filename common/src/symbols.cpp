@@ -0,0 +1,61 @@
+#include "../inc/symbols.hpp"
+#include <format>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+SymbolTable::const_iterator SymbolTable::begin() const {
+    return _symbols.begin();
+}
+
+SymbolTable::const_iterator SymbolTable::end() const {
+    return _symbols.end();
+}
+
+bool SymbolTable::empty() const {
+    return _symbols.empty();
+}
+
+void SymbolTable::add(size_t address, const std::string& label) {
+    _symbols.emplace(address, label);
+}
+
+std::optional<SymbolTable::Location> SymbolTable::find(size_t address) const {
+    auto it = _symbols.upper_bound(address);
+    if (it == _symbols.begin())
+        return std::nullopt;
+    --it;
+    return Location { &it->second, address - it->first };
+}
+
+std::string SymbolTable::format(size_t address) const {
+    const auto location = find(address);
+    if (!location.has_value())
+        return std::format("{:04x}", address);
+    if (location->offset == 0)
+        return *location->label;
+    return std::format("{}+0x{:x}", *location->label, location->offset);
+}
+
+void SymbolTable::write(const std::string& filename) const {
+    std::ofstream file(filename);
+    for (const auto& [address, label]: _symbols)
+        file << std::format("{:04x} {}\n", address, label);
+}
+
+void SymbolTable::read(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file)
+        throw std::runtime_error("SymbolTable: cannot open " + filename);
+    std::string line;
+    for (size_t number = 1; std::getline(file, line); ++number) {
+        if (line.empty())
+            continue;
+        std::istringstream fields(line);
+        size_t address;
+        std::string label;
+        if (!(fields >> std::hex >> address >> label))
+            throw std::runtime_error(std::format("SymbolTable: bad line {} in {}", number, filename));
+        add(address, label);
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "computer.hpp"
+
+// PC breakpoints and memory watchpoints, as a probe that stops the core when one is hit.
+// Attach it to a core only while any are set (the core runs its unchecked loop otherwise).
+// The core stops before an instruction with a breakpoint, and after an instruction that loads or
+// stores a watched address. Breakpoints can be set and removed from another thread while the core runs.
+class Breakpoints: public Probe {
+public:
+    enum Kind : uint8_t {
+        BREAK = 1 << 0, // execute
+        READ = 1 << 1,
+        WRITE = 1 << 2,
+    };
+
+    struct Entry {
+        uint16_t first;
+        uint16_t last; // inclusive
+        uint8_t kinds;
+    };
+
+    struct Hit {
+        Kind kind;
+        uint16_t pc; // of the instruction that hit it
+        uint16_t address; // accessed address (pc for a breakpoint)
+        uint64_t cycle;
+    };
+
+private:
+    std::array<std::atomic_uint8_t, 0x10000> _flags; // kinds set on each address
+    std::map<size_t, Entry> _entries; // by id
+    size_t _next_id;
+
+    std::mutex _hits_mutex;
+    std::vector<Hit> _hits;
+
+    void _update(uint16_t first, uint16_t last);
+    void _hit(const Hit& hit);
+
+public:
+    Breakpoints();
+
+    // set a breakpoint or watchpoint on an address range, returns its id
+    size_t add(uint16_t first, uint16_t last, uint8_t kinds);
+    // returns false if there is no entry with the id
+    bool remove(size_t id);
+    void clear();
+
+    bool empty() const;
+    const std::map<size_t, Entry>& entries() const;
+
+    // return the hits since the last call
+    std::vector<Hit> take_hits();
+
+    bool instruction(const Computer::State& state) override;
+    bool access(const Computer::State& state, uint16_t address, bool write) override;
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <ostream>
+#include <unordered_map>
+#include <utility>
+
+#include "../../../common/inc/symbols.hpp"
+#include "computer.hpp"
+
+// Probe that rebuilds the call stack and attributes cycles to functions, identified by their entry
+// address. The ISA has no hardware stack for return addresses (programs spill ra themselves), so it
+// keeps a shadow stack instead: every instruction that saves ra (call, rcall, cbl, cbh, callret) pushes
+// a frame, and a jump through ra (ret, callret) pops down to the frame it returns to. A return that
+// matches no frame (e.g. one that moved ra past data after the call) pops the top frame, or starts a
+// new root if it is the only one. Cycles spent halted count for the function that halted.
+class CallProfiler: public Probe {
+public:
+    struct Edge {
+        uint64_t calls;
+        uint64_t inclusive; // cycles from the call to the return
+    };
+
+    struct Function {
+        uint64_t exclusive;
+        std::map<std::pair<uint16_t, uint16_t>, Edge> callees; // by (callee entry, call site)
+    };
+
+    static constexpr size_t MAX_DEPTH = 4096; // deeper frames drop the outermost
+
+private:
+    struct Frame {
+        Function* function;
+        uint16_t entry;
+        uint16_t call_site;
+        uint16_t return_address;
+        bool root; // nothing to return to
+        uint64_t cycle; // at the call
+    };
+
+    std::unordered_map<uint16_t, Function> _functions;
+    std::deque<Frame> _stack;
+    uint64_t _cycle; // at the last instruction boundary
+    uint16_t _pc; // of the instruction that finishes at the next one
+    uint64_t _resyncs;
+
+    Function& _function(uint16_t entry);
+    void _push(uint16_t entry, uint16_t call_site, uint16_t return_address, bool root, uint64_t cycle);
+    void _return(uint16_t target, uint64_t cycle);
+    // inclusive cycles of the frames still on the stack at cycle
+    std::map<std::pair<const Function*, std::pair<uint16_t, uint16_t>>, uint64_t> _open(uint64_t cycle) const;
+
+public:
+    CallProfiler();
+
+    void clear();
+
+    const std::unordered_map<uint16_t, Function>& functions() const;
+    // returns that matched no frame
+    uint64_t resyncs() const;
+
+    // functions sorted by exclusive cycles, with their inclusive cycles (which count recursive
+    // calls more than once), up to cycle
+    void report(std::ostream& out, const SymbolTable& symbols, uint64_t cycle, size_t top = 20) const;
+    // callgrind format, for KCachegrind (positions are instruction addresses)
+    void write_callgrind(std::ostream& out, const SymbolTable& symbols, uint64_t cycle) const;
+
+    bool instruction(const Computer::State& state) override;
+};
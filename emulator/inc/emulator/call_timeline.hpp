@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+
+#include "../../../common/inc/symbols.hpp"
+#include "computer.hpp"
+#include "event_trace.hpp"
+
+// Probe that adds a span to an EventTrace for every guest function call, from the call to its
+// return in host time, on the guest track of its core and named by the symbol of the entry address.
+// Calls and returns are found like CallProfiler does: instructions that save ra push a frame, and a
+// jump through ra pops down to the frame it returns to (or the top frame, if none matches).
+class CallTimeline: public Probe {
+private:
+    struct Frame {
+        uint16_t entry;
+        uint16_t return_address;
+        uint64_t begin; // host ns
+    };
+
+    static constexpr size_t MAX_DEPTH = 4096; // deeper frames drop the outermost, without a span
+
+    EventTrace& _trace;
+    const SymbolTable& _symbols;
+    const uint32_t _core;
+    std::deque<Frame> _stack;
+    bool _started;
+
+    void _end(const Frame& frame, uint64_t end);
+
+public:
+    CallTimeline(EventTrace& trace, const SymbolTable& symbols, uint32_t core);
+
+    // end the spans of the calls still open
+    void finish();
+
+    bool instruction(const Computer::State& state) override;
+};
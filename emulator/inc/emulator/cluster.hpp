@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "computer.hpp"
+#include "memory.hpp"
+
+// Group of CPU cores sharing one memory bus, each run on its own thread.
+// Cores synchronize at the end of every quantum of cycles.
+class Cluster {
+public:
+    enum class Sync {
+        // cores run their quanta concurrently (fast, but shared memory accesses interleave nondeterministically)
+        PARALLEL,
+        // cores take turns running their quanta in index order (reproducible results)
+        DETERMINISTIC,
+    };
+
+private:
+    std::vector<std::unique_ptr<Computer>> _cores;
+
+public:
+    Cluster() = delete;
+    Cluster(const Cluster&) = delete;
+    Cluster(Cluster&&) = delete;
+
+    Cluster(size_t cores, const MemoryDevicePointer& memory);
+
+    size_t size() const;
+    Computer& core(size_t index);
+    const Computer& core(size_t index) const;
+    // every core, e.g. for Machine::snapshot()
+    std::vector<Computer*> cores();
+
+    // reset every core to its starting state, leaving the core index in gd
+    void reset();
+
+    // fill all memory and registers with zeroes to make debugging easier
+    void debug_init();
+
+    // run every core for count cycles, synchronizing after each quantum of cycles
+    // stops at the end of the quantum in which a probe stops any core, or once every core is halted
+    // until an event
+    void step_sync(uint64_t count, uint64_t quantum, Sync sync);
+};
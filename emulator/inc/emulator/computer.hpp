@@ -1,21 +1,29 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <limits>
+#include <optional>
 #include <thread>
+#include <type_traits>
+#include <vector>
 
+#include "input_log.hpp"
 #include "memory.hpp"
 #include "spinlock.hpp"
 
+// build with -DEMULATOR_STATISTICS=1 (make STATISTICS=1) to count what the cores execute
+#ifndef EMULATOR_STATISTICS
+#define EMULATOR_STATISTICS 0
+#endif
 
+class CoverageMap;
+class Probe;
+class Profiler;
 
 class Computer {
-private:
-    mutable MSSpinLock _state_lock;
-    MemoryDevicePointer _memory;
-    std::thread _run_thread;
-    std::atomic_bool _run;
-
+public:
     struct State {
         uint64_t cycle;
         uint16_t pc;
@@ -33,12 +41,80 @@ private:
         bool alu_write; // DECODE -> EXECUTE -> MEMORY -> WRITE
         bool alu_set_flags; // DECODE -> EXECUTE
         bool take_jump; // DECODE -> EXECUTE
+        bool halted; // waiting for an event or the wake cycle
+        uint64_t wake_cycle; // cycle at which a halted core resumes (0 = only on an event)
+    };
+
+    // cycles per unit of the value written to the wait register
+    static constexpr uint64_t WAIT_UNIT = 256;
+
+    // whether the cores keep Statistics; without it the counting compiles to nothing
+    static constexpr bool STATISTICS = EMULATOR_STATISTICS;
+
+    // counters kept by the core as it executes, in their own cache lines next to the state
+    struct alignas(64) Statistics {
+        uint64_t formats[4]; // instructions decoded by format (A, IA, M, C)
+        uint64_t alu_ops[16]; // ALU operations of A and IA instructions by op
+        uint64_t branches_taken;
+        uint64_t branches_not_taken;
+        uint64_t loads;
+        uint64_t stores;
+        uint64_t stage_cycles[5]; // cycles spent in each pipeline stage
+        uint64_t halted_cycles; // cycles skipped while halted
     };
 
+    // loads and stores by bus page (address >> 8), counted by a core they are attached to in any
+    // build (see attach_page_accesses()) and readable with relaxed atomics while it runs
+    struct PageAccesses {
+        uint64_t loads[256];
+        uint64_t stores[256];
+    };
+
+private:
+    // the microbenchmarks (src/bench) drive the pipeline stages directly
+    friend class PipelineBench;
+
+    mutable MSSpinLock _state_lock;
+    MemoryDevicePointer _memory;
+    std::thread _run_thread;
+    std::atomic_bool _run;
+    std::atomic_uint32_t _events; // incremented by wake()
+    std::atomic_uint32_t _signal; // futex word the run thread parks on
+    uint32_t _seen_events;
+    InputLog* _input_log;
+    std::vector<Probe*> _probes;
+    Profiler* _profiler;
+    CoverageMap* _coverage;
+    PageAccesses* _page_accesses;
+    uint64_t _probe_stop_cycle; // cycle a probe last stopped the core at
+    bool _probe_stopped; // a probe stopped the current run
+    bool _probe_access_hit; // a probe asked to stop after the current instruction's memory access
+    bool _probes_muted;
+    Probe* _unmuted_probe; // still called while the others are muted
+    bool _trap_faults;
+    std::atomic_uint64_t _published_cycle; // state.cycle as of the end of the last batch
+
     State state;
+    // without STATISTICS the counters take no space and the core's layout is as if they didn't exist
+    struct NoStatistics {};
+    [[no_unique_address]] std::conditional_t<STATISTICS, Statistics, NoStatistics> _statistics;
+
+    // call f with the counters, or not at all without STATISTICS
+    template <typename F>
+    void _with_statistics(F&& f) {
+        if constexpr (STATISTICS)
+            f(_statistics);
+    }
+    template <typename F>
+    void _with_statistics(F&& f) const {
+        if constexpr (STATISTICS)
+            f(_statistics);
+    }
 
     [[noreturn]] void throw_eil();
+    void _check_fault(size_t address, const MemoryResult& result);
 
+    template <bool CHECKED>
     void fetch_stage();
     void decode_alu_op();
     void decode_x_register();
@@ -49,13 +125,29 @@ private:
     void decode_jump_condition();
     void decode_stage();
     void execute_stage();
+    template <bool CHECKED>
     void memory_stage();
     void writeback_stage();
 
+    void _halt(uint8_t timeout);
+    bool _idle() const;
+    bool _take_event();
+    uint64_t _wake_cycle() const;
+    uint8_t _read_input(uint16_t address);
+    [[noreturn]] void _replay_diverged();
+    uint64_t _skip_halted(uint64_t count);
+    void _park(std::optional<std::chrono::nanoseconds> timeout = std::nullopt);
+
+    template <bool CHECKED>
     void _step();
+    bool _call_probes();
+    void _call_access_probes(uint16_t address, bool write);
+    template <bool CHECKED>
+    uint64_t _execute(uint64_t count);
+    uint64_t _execute(uint64_t count);
 
     void _run_worker(std::chrono::high_resolution_clock::duration period);
-    void _step_worker(uint64_t count);
+    void _step_worker(uint64_t count, bool park);
     void _freerun_worker();
 
 public:
@@ -63,6 +155,8 @@ public:
     ~Computer();
 
     void attach_memory(const MemoryDevicePointer& device);
+    // record the core's events and input port reads to a log, or replay them from it (nullptr to detach)
+    void attach_input_log(InputLog* log);
 
     // reset the computer to its starting state
     void reset();
@@ -70,9 +164,15 @@ public:
     // pause execution
     void stop();
 
+    // signal an event (e.g. input), resuming the core if it is halted
+    void wake();
+    // return true if the core is halted
+    bool halted() const;
+
     // run the computer for count cycles (default 1)
     void step(uint64_t count = 1);
     // run the computer for count cycles (default 1) in the same thread
+    // returns early if the core halts until an event, since nothing can wake it
     void step_sync(uint64_t count = 1);
 
     // run the computer at a specified number of cycles per second (default infinity - runs without timer overhead)
@@ -81,6 +181,54 @@ public:
     // fill all memory and registers with zeroes to make debugging easier
     void debug_init();
 
+    // return a copy of the computer's state
+    State get_state() const;
+    // return a copy of the counters (all zero unless built with STATISTICS)
+    Statistics get_statistics() const;
+    // read the counters with relaxed atomics, without waiting for the core; meant for monitoring while
+    // it runs, as each counter is exact but they aren't from the same instant
+    Statistics peek_statistics() const;
+    void reset_statistics();
+    // the cycle count as of the end of the last batch the core ran, also read without waiting for it
+    uint64_t peek_cycle() const;
+    // overwrite the computer's state
+    void set_state(const State& state);
+
+    // call a probe before every instruction
+    void attach_probe(Probe* probe);
+    void detach_probe(Probe* probe);
+    // stop calling the probes (without detaching them), e.g. while replaying execution that already happened
+    // except one, e.g. a probe searching the replay
+    void mute_probes(bool mute = true, Probe* except = nullptr);
+    // count every instruction into a profiler, or record coverage into a map (nullptr to detach)
+    // both engines update them inline as each instruction is decoded, so unlike a probe they don't
+    // need the checked engine, and they aren't muted
+    void attach_profiler(Profiler* profiler);
+    void attach_coverage(CoverageMap* coverage);
+    // count loads and stores by page (nullptr to detach), in both engines
+    void attach_page_accesses(PageAccesses* accesses);
+    // return true if a probe stopped the last run or step
+    bool stopped_by_probe() const;
+
+    // throw on accesses to unmapped addresses and on reads or writes the device doesn't allow
+    // (by default they are ignored and reads return 0)
+    void trap_memory_faults(bool trap = true);
+    // return true if the core runs its checked loop (probes attached or memory faults trapped),
+    // which is slower than the unchecked one
+    bool checked() const;
+
     // return a string containing the computer's state in a human-readable format
     std::string debug_state() const;
+};
+
+// Instrumentation called by a core before every instruction while attached (see Computer::attach_probe()).
+class Probe {
+public:
+    virtual ~Probe() = default;
+
+    // called before the instruction at state.pc is fetched, returns true to stop the core there
+    virtual bool instruction(const Computer::State& state) = 0;
+    // called on every load and store (not instruction fetches), returns true to stop the core
+    // once the instruction completes
+    virtual bool access(const Computer::State& state, uint16_t address, bool write);
 };
\ No newline at end of file
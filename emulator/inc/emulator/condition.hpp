@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "computer.hpp"
+#include "memory.hpp"
+
+// Integer expression over a core's state and memory, compiled once into bytecode for a small stack
+// machine so it is cheap enough to evaluate at every instruction boundary. Nonzero is true.
+//   values:    decimal or 0x hex numbers, pc, cycle, stage, halted, registers (ra, sr, sp, fp/ga, gb, gc,
+//              gd, ge, gf, gg, gh, and ra.l, ra.h, ge.l, ... for the bytes of wide registers),
+//              flags (c, v, n, z), [a] for the byte at address a
+//   operators: ! ~ - (unary), + -, &, ^, |, == != < <= > >=, x in a..b (a <= x <= b), &&, || (short circuit)
+//              with C precedence, and parentheses
+// Memory is read through the bus, so reading an io port has its usual side effects.
+class Condition {
+public:
+    enum class Op : uint8_t {
+        PUSH, // operand
+        PC,
+        CYCLE,
+        STAGE,
+        HALTED,
+        REG8, // register index
+        REG16, // index of the low byte
+        FLAG, // bit in sr
+        LOAD,
+        NOT,
+        NEG,
+        INV,
+        ADD,
+        SUB,
+        AND,
+        XOR,
+        OR,
+        EQ,
+        NE,
+        LT,
+        LE,
+        GT,
+        GE,
+        IN, // x a b -> a <= x <= b
+        BOOL, // normalize to 0 or 1
+        JZ, // jump to operand if the top is zero, leaving it, else pop it
+        JNZ, // jump to operand if the top is nonzero, leaving it, else pop it
+    };
+
+    struct Instruction {
+        Op op;
+        int64_t operand;
+    };
+
+    static constexpr size_t MAX_DEPTH = 32;
+
+private:
+    std::string _expression;
+    std::vector<Instruction> _code;
+
+public:
+    // throws std::invalid_argument on a syntax error
+    explicit Condition(const std::string& expression);
+
+    int64_t evaluate(const Computer::State& state, const MemoryDevice& memory) const;
+
+    const std::string& expression() const;
+    const std::vector<Instruction>& code() const;
+};
+
+// Probe that stops the core the first time a condition holds at an instruction boundary.
+class StopCondition: public Probe {
+private:
+    const Condition _condition;
+    const MemoryDevicePointer _memory;
+    std::atomic_bool _met;
+
+public:
+    StopCondition(const Condition& condition, const MemoryDevicePointer& memory);
+
+    const Condition& condition() const;
+    // return true once the condition has held (and stopped the core)
+    bool met() const;
+
+    bool instruction(const Computer::State& state) override;
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include "../../../common/inc/encoding.hpp"
+#include "../../../common/inc/memorymap.hpp"
+#include "../../../common/inc/symbols.hpp"
+
+// Records which instruction addresses have executed and, for conditional control instructions,
+// whether they were taken, not taken or both. Every address has a 4-bit cell of
+// EXECUTED | TAKEN | NOT_TAKEN, which the core sets directly as it decodes the instruction (see
+// Computer::attach_coverage()) with a single OR and no branches, in either engine.
+// Maps from several runs merge by OR-ing their cells.
+class CoverageMap {
+public:
+    enum Bit : uint8_t {
+        EXECUTED = 1,
+        TAKEN = 2,
+        NOT_TAKEN = 4,
+    };
+
+    static constexpr size_t CELL_BITS = 4;
+    static constexpr size_t WORDS = 0x10000 * CELL_BITS / 64;
+
+    // control instructions whose condition isn't "always"
+    static constexpr bool is_conditional(uint16_t instruction) {
+        const bool control = (instruction & *Encoding::FMT_MASK) >> *Encoding::FMT_SHIFT == *Encoding::FMT_C;
+        const bool always = (instruction & (*Encoding::C_MASK | *Encoding::N_MASK)) == *JumpCond::ALW << *Encoding::C_SHIFT;
+        return control && !always;
+    }
+
+private:
+    std::array<uint64_t, WORDS> _cells;
+
+public:
+    CoverageMap();
+
+    void clear();
+    void merge(const CoverageMap& other);
+
+    // Bit flags of an address
+    uint8_t cell(uint16_t pc) const;
+
+    // write the map, or OR one written by write() into this one (throws std::runtime_error)
+    void write(const std::string& filename) const;
+    void read(const std::string& filename);
+
+    // instructions executed and branch outcomes seen in the program, per label (or per section of
+    // the program when there are no symbols), counting every even address of the program as an
+    // instruction
+    void report(std::ostream& out, const MemoryMap& program, const SymbolTable& symbols) const;
+
+    // record an instruction and whether it jumps (called by the core)
+    void executed(uint16_t pc, uint16_t instruction, bool taken) {
+        const uint64_t bits = EXECUTED | uint64_t(is_conditional(instruction)) << (1 + !taken);
+        _cells[pc * CELL_BITS / 64] |= bits << (pc * CELL_BITS % 64);
+    }
+};
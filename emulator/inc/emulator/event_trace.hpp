@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Timeline of host and guest activity in the Chrome trace-event format (JSON that Perfetto and
+// chrome://tracing open). While a trace is started, instrumented code records complete spans on the
+// host thread they ran on, and guest spans go on a track per core; with no trace started an
+// instrumented point costs a relaxed atomic load. Each process keeps up to MAX_EVENTS spans, so a
+// busy guest can't crowd out the host's; spans past that are dropped and counted.
+class EventTrace {
+public:
+    enum Process : uint32_t {
+        HOST = 1,
+        GUEST = 2, // one track per core
+    };
+    static constexpr size_t PROCESS_COUNT = 2;
+
+    // records a span on the current thread from its construction to its destruction, if a trace was
+    // started when it was constructed
+    class Span {
+    private:
+        EventTrace* _trace;
+        const char* _name;
+        const char* _category;
+        uint64_t _begin;
+
+    public:
+        Span(const Span&) = delete;
+        Span(Span&&) = delete;
+
+        Span(const char* name, const char* category);
+        ~Span();
+    };
+
+    static constexpr size_t MAX_EVENTS = 1 << 22; // per process
+
+private:
+    struct Event {
+        std::string name;
+        const char* category;
+        uint64_t begin; // ns, see now()
+        uint64_t end;
+        uint32_t process;
+        uint32_t track;
+    };
+
+    static std::atomic<EventTrace*> _active;
+
+    mutable std::mutex _mutex;
+    std::vector<Event> _events;
+    std::unordered_map<uint64_t, std::string> _track_names; // by process << 32 | track
+    size_t _counts[PROCESS_COUNT]; // by process - 1
+    uint64_t _dropped[PROCESS_COUNT];
+
+public:
+    EventTrace(const EventTrace&) = delete;
+    EventTrace(EventTrace&&) = delete;
+
+    EventTrace();
+    // stops the trace if it is still started
+    ~EventTrace();
+
+    // the started trace, or nullptr
+    static EventTrace* active() {
+        return _active.load(std::memory_order_relaxed);
+    }
+    // host time in ns on the trace's timeline
+    static uint64_t now();
+    // small number identifying the calling thread on the HOST process
+    static uint32_t thread_track();
+
+    // make this the trace that instrumented code records to (only one at a time)
+    void start();
+    // spans keep the trace they started on and record to it when they end, so stop (or destroy) a
+    // trace only once every thread that may be inside a span has been stopped or joined
+    void stop();
+
+    void span(const std::string& name, const char* category, uint64_t begin, uint64_t end, uint32_t process, uint32_t track);
+    // name the calling thread's track on the timeline
+    void name_thread(const std::string& name);
+    void name_track(uint32_t process, uint32_t track, const std::string& name);
+
+    uint64_t dropped(Process process) const;
+
+    // throws std::runtime_error if the file can't be written
+    void write(const std::string& filename) const;
+};
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../../../common/inc/memorymap.hpp"
+#include "computer.hpp"
+#include "machine.hpp"
+
+// Pool of worker threads running many independent machines in-process.
+// Every worker owns a deque of jobs; idle workers steal from the others.
+// Jobs run in time slices so long jobs don't starve short ones.
+class Farm {
+public:
+    static constexpr uint64_t DEFAULT_SLICE = 100000;
+
+    struct Patch {
+        size_t address;
+        std::vector<uint8_t> data;
+    };
+
+    struct Job {
+        MemoryMap image;
+        std::vector<Patch> patches; // written after the image is loaded
+        uint64_t cycles;
+    };
+
+    struct Result {
+        Computer::State state;
+        std::vector<uint8_t> screen; // character memory, width * height * 2 bytes
+    };
+
+private:
+    struct Task {
+        Job job;
+        std::promise<Result> promise;
+        std::unique_ptr<Machine> machine;
+        std::unique_ptr<Computer> computer;
+        uint64_t remaining;
+
+        Task(Job&& job);
+    };
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::unique_ptr<Task>> tasks;
+    };
+
+    const uint64_t _slice;
+    std::vector<std::unique_ptr<Queue>> _queues;
+    std::vector<std::thread> _workers;
+    std::atomic_bool _exit;
+    std::atomic<size_t> _queued;
+    std::atomic<size_t> _next_queue;
+    std::mutex _idle_mutex;
+    std::condition_variable _idle;
+
+    void _push(size_t index, std::unique_ptr<Task>&& task);
+    std::unique_ptr<Task> _take(size_t index);
+    bool _run_slice(Task& task);
+    void _worker(size_t index);
+
+public:
+    Farm(const Farm&) = delete;
+    Farm(Farm&&) = delete;
+
+    Farm(size_t workers = std::thread::hardware_concurrency(), uint64_t slice = DEFAULT_SLICE);
+    ~Farm();
+
+    size_t size() const;
+
+    // queue a job; jobs still queued when the farm is destroyed are abandoned (their futures report broken_promise)
+    std::future<Result> submit(Job job);
+};
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "computer.hpp"
+#include "machine.hpp"
+#include "snapshot.hpp"
+
+// Coverage-guided fuzzer for a guest routine that reads its input from memory.
+// The machine runs once up to the start pc and is snapshotted there. Every run restores the
+// snapshot (copying back only the pages written since), writes an input into the input region and
+// runs until the cycle budget is used up, the core halts until an event, or it crashes (illegal
+// instruction or memory fault). Inputs that reach a new edge, or an edge a new number of times,
+// are kept in the corpus and mutated further.
+// Other snapshots of the machine must not be taken or restored while the fuzzer is in use.
+class Fuzzer {
+public:
+    static constexpr size_t MAP_SIZE = 1 << 16;
+
+    struct Config {
+        uint16_t start; // pc to snapshot at
+        uint16_t input_address;
+        uint16_t input_size;
+        uint64_t budget; // cycles per run
+        uint64_t start_budget; // cycles allowed to reach the start pc
+        uint64_t seed;
+    };
+
+    struct Crash {
+        std::vector<uint8_t> input;
+        std::string what;
+        Computer::State state;
+    };
+
+    struct Stats {
+        uint64_t runs;
+        uint64_t crashes; // runs that crashed, including repeats of a known crash
+        uint64_t edges; // edges reached so far
+    };
+
+private:
+    // Counts the edges (pairs of consecutive instructions) taken during a run.
+    class Coverage: public Probe {
+    public:
+        uint8_t hits[MAP_SIZE];
+        std::vector<uint16_t> touched; // edges with a non-zero hit count
+        uint16_t previous;
+
+        bool instruction(const Computer::State& state) override;
+    };
+
+    Machine& _machine;
+    Computer& _core;
+    const Config _config;
+    std::mt19937_64 _random;
+
+    std::shared_ptr<const Snapshot> _start;
+    Coverage _coverage;
+    uint8_t _seen[MAP_SIZE]; // hit count classes seen for each edge
+    std::vector<std::vector<uint8_t>> _corpus;
+    std::map<std::pair<uint16_t, std::string>, Crash> _crashes; // by pc and message
+    Stats _stats;
+
+    std::vector<uint8_t> _mutate();
+    bool _collect();
+
+public:
+    Fuzzer(const Fuzzer&) = delete;
+    Fuzzer(Fuzzer&&) = delete;
+
+    // the core must be attached to the machine's memory and stopped
+    Fuzzer(Machine& machine, Computer& core, const Config& config);
+    ~Fuzzer();
+
+    // run the core to the start pc and snapshot it there
+    // throws if the start pc isn't reached within the start budget
+    void prepare();
+
+    // run an input as given (shorter inputs are padded with zeroes), adding it to the corpus if it reaches
+    // new coverage, returns the crash if it crashed
+    std::optional<Crash> run(const std::vector<uint8_t>& input);
+    // run a mutation of a corpus input (or of zeroes while the corpus is empty)
+    std::optional<Crash> fuzz();
+
+    const Stats& stats() const;
+    const std::vector<std::vector<uint8_t>>& corpus() const;
+    // one crash for every distinct pc and message
+    const std::map<std::pair<uint16_t, std::string>, Crash>& crashes() const;
+};
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+#include "computer.hpp"
+#include "input_log.hpp"
+#include "machine.hpp"
+#include "snapshot.hpp"
+
+// Execution history of a single core, for going backwards in time.
+// While the core runs through run() or step(), a recorder thread briefly stops it at every interval
+// to take an incremental checkpoint (not while it is halted, when nothing changes). The core records
+// the events it takes and its input port reads to the history's input log, so going back restores
+// the nearest earlier checkpoint and replays forward from it exactly as the core ran. Running on
+// afterwards keeps replaying the log until it runs out, while outside events are dropped. When the
+// checkpoints outgrow the budget, the oldest are merged away along with the log entries before them.
+// Other snapshots of the machine must not be taken or restored, and no other input log attached to
+// the core, while the history is in use.
+class History {
+public:
+    static constexpr size_t DEFAULT_BUDGET = 64 << 20;
+    static constexpr std::chrono::milliseconds DEFAULT_INTERVAL { 10 };
+
+private:
+    Machine& _machine;
+    Computer& _core;
+    const size_t _budget;
+    const std::chrono::milliseconds _interval;
+
+    std::deque<std::shared_ptr<Snapshot>> _checkpoints; // oldest first
+    size_t _bytes;
+    InputLog _input_log;
+    bool _keep_input_log;
+
+    std::thread _recorder;
+    std::mutex _mutex;
+    std::condition_variable _wake_recorder;
+    bool _recording;
+    double _freq; // of the current run
+    std::optional<uint64_t> _step_end; // cycle the current step ends at (none while running)
+
+    uint64_t _cycle() const;
+    void _checkpoint();
+    void _merge(size_t index);
+    void _merge_oldest();
+    void _truncate();
+    void _resume();
+    void _restore(const std::shared_ptr<const Snapshot>& checkpoint);
+    void _replay(uint64_t cycle, Probe* search = nullptr, const std::function<void()>& stopped = nullptr);
+    void _record_worker();
+
+public:
+    History(const History&) = delete;
+    History(History&&) = delete;
+
+    History(Machine& machine, Computer& core, size_t budget = DEFAULT_BUDGET, std::chrono::milliseconds interval = DEFAULT_INTERVAL);
+    ~History();
+
+    // same as Computer::run(), step() and stop(), recording checkpoints on the way
+    void run(double freq = std::numeric_limits<double>::infinity());
+    void step(uint64_t count = 1);
+    void stop();
+
+    // go back count cycles (limited by the oldest checkpoint), returns the number of cycles gone back
+    uint64_t step_back(uint64_t count = 1);
+    // go back to the latest instruction boundary where stop returns true
+    // returns false and goes back to the oldest checkpoint if there is none
+    bool reverse_until(const std::function<bool(const Computer::State&)>& stop);
+
+    // the log of the core's events and input port reads
+    InputLog& input_log();
+    // keep the whole log (e.g. to write it out) instead of dropping the entries older than the oldest checkpoint
+    void keep_input_log(bool keep = true);
+
+    // memory held by the checkpoints
+    size_t bytes() const;
+    // cycle of the oldest checkpoint (the furthest the core can go back)
+    uint64_t oldest() const;
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string>
+
+// Hardware performance counters of the host (Linux perf events), counting user-space work of the
+// thread that creates them and of the threads it starts afterwards (e.g. the cluster's core threads,
+// once they have been joined). Used to relate the host's work to the guest's progress. Counters the
+// host can't provide (no permission, no PMU in a virtual machine, not Linux) are left out.
+class HostCounters {
+public:
+    enum Event {
+        CYCLES,
+        INSTRUCTIONS,
+        BRANCH_MISSES,
+        CACHE_MISSES,
+        EVENT_COUNT
+    };
+
+    static constexpr const char* EVENT_NAMES[EVENT_COUNT] { "cycles", "instructions", "branch-misses", "cache-misses" };
+
+    // counts since the counters were opened, scaled up if the kernel had to multiplex them
+    struct Sample {
+        std::optional<uint64_t> counts[EVENT_COUNT];
+    };
+
+private:
+    int _fds[EVENT_COUNT];
+    std::string _error; // why the first counter that couldn't be opened wasn't
+
+public:
+    HostCounters(const HostCounters&) = delete;
+    HostCounters(HostCounters&&) = delete;
+
+    // open and start every counter the host provides
+    HostCounters();
+    ~HostCounters();
+
+    // return true if at least one counter is open
+    bool available() const;
+    const std::string& error() const;
+
+    Sample read() const;
+
+    // write the counts between two samples per guest instruction and per guest cycle
+    static void report(std::ostream& out, const Sample& begin, const Sample& end, uint64_t guest_instructions, uint64_t guest_cycles);
+};
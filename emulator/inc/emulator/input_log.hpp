@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Log of the nondeterministic inputs of a core, for replaying a run exactly.
+// While recording, the core logs every event it takes (see Computer::wake()) and every read from an
+// input port, at the cycle it happened; the command thread logs where it stopped the core. While
+// replaying, the core takes its events and port reads from the log instead, so it runs the same
+// way without the devices or the timing of the original run. A replay that reaches the end of the
+// log goes back to recording.
+class InputLog {
+public:
+    enum class Kind : uint8_t {
+        EVENT, // the core took an event
+        READ, // the core read a value from an input port
+        STOP, // the command thread stopped the core
+    };
+
+    struct Entry {
+        uint64_t cycle;
+        Kind kind;
+        uint16_t address; // READ only
+        uint8_t value; // READ only
+    };
+
+private:
+    std::vector<std::pair<size_t, size_t>> _ports; // (address, size)
+    std::vector<Entry> _entries;
+    size_t _next; // next entry to replay
+    bool _replaying;
+
+    void _skip_stops();
+    void _advance();
+
+public:
+    InputLog();
+
+    // mark an address range whose reads are inputs
+    void add_port(size_t address, size_t size);
+    bool is_port(size_t address) const;
+
+    bool replaying() const;
+    const std::vector<Entry>& entries() const;
+    // cycle of the last entry (where a replay ends)
+    uint64_t end() const;
+
+    void record(const Entry& entry);
+    void record_stop(uint64_t cycle);
+
+    // next event or port read to replay (nullptr at the end of the log)
+    const Entry* next() const;
+    void pop();
+    // start replaying from the beginning
+    void rewind();
+    // start replaying from the first entry at or after a cycle
+    void seek(uint64_t cycle);
+    // drop the entries before a cycle (which can no longer be replayed)
+    void discard_before(uint64_t cycle);
+
+    // the ports are saved with the entries
+    // entries are stored as a kind byte and the varint distance in cycles from the previous entry
+    void write(const std::string& filename) const;
+    // read a log and start replaying it
+    void read(const std::string& filename);
+};
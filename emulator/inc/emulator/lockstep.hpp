@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "../../../common/inc/memorymap.hpp"
+#include "computer.hpp"
+#include "machine.hpp"
+#include "snapshot.hpp"
+
+// Differential tester: runs the same program on two cores, each on a machine of its own and with its
+// own execution engine, one instruction at a time. At every instruction boundary it compares the
+// cores' pc, registers (sr included), cycle and halt state, and the memory writes the instruction
+// made, and stops at the first difference.
+class Lockstep {
+public:
+    // the loops a core can run (see Computer::checked())
+    enum class Engine {
+        UNCHECKED, // the fast loop, with nothing attached
+        CHECKED, // the loop that calls probes (a probe that does nothing is attached)
+    };
+
+    struct Write {
+        uint16_t address;
+        uint8_t value;
+
+        bool operator==(const Write&) const = default;
+    };
+
+    // what the two cores did on the instruction they disagree on
+    struct Side {
+        Computer::State state; // after the instruction
+        std::vector<Write> writes;
+        std::string error; // what the instruction threw, if anything
+    };
+
+    struct Divergence {
+        uint64_t instructions; // instructions both cores ran alike before
+        Computer::State before; // reference state at the boundary before the instruction
+        Side reference;
+        Side test;
+
+        // one line per difference
+        std::string describe() const;
+    };
+
+private:
+    class WriteLog;
+    class NullProbe: public Probe {
+    public:
+        bool instruction(const Computer::State& state) override;
+    };
+
+    struct Core {
+        Machine machine;
+        Computer computer;
+        MemoryDevicePointer bus; // the machine's memory, logging writes
+        NullProbe probe;
+        std::shared_ptr<const Snapshot> blank; // zeroed memory and registers, after reset
+
+        Core(Engine engine);
+        ~Core();
+
+        std::vector<Write>& writes();
+        // zero the machine and load an image, much faster than Computer::debug_init()
+        void load(const MemoryMap& map);
+        // run the next instruction (five cycles), returning what it threw, if anything
+        std::string step();
+    };
+
+    std::unique_ptr<Core> _reference;
+    std::unique_ptr<Core> _test;
+    std::optional<MemoryMap> _image; // where the run started: the image loaded
+    std::shared_ptr<const Snapshot> _origin; // or the snapshot restored
+    Computer::State _state; // of the reference core, at the last boundary
+    uint64_t _instructions;
+    bool _finished;
+
+public:
+    static constexpr uint64_t CYCLES_PER_INSTRUCTION = 5;
+
+    Lockstep(const Lockstep&) = delete;
+    Lockstep(Lockstep&&) = delete;
+
+    Lockstep(Engine reference, Engine test);
+    ~Lockstep();
+
+    // load a program image into both machines and reset the cores
+    void load(const MemoryMap& map);
+    // continue both from a snapshot of a single core machine (after load())
+    void restore(const std::shared_ptr<const Snapshot>& snapshot);
+
+    // run up to count instructions, returning the first divergence, if any
+    // also stops when both cores are halted until an event, or both threw alike (see finished())
+    std::optional<Divergence> run(uint64_t count);
+
+    // instructions both cores ran alike
+    uint64_t instructions() const;
+    // true once neither core can go on (halted until an event or an error), alike
+    bool finished() const;
+
+    // run the reference core again from where the run started (load() or restore()) for count
+    // instructions and snapshot it there, e.g. at the boundary before a divergence as a repro
+    // the cores are out of step afterwards, until the next load() or restore()
+    std::shared_ptr<Snapshot> replay_reference(uint64_t count);
+
+    static std::optional<Engine> parse_engine(const std::string& name);
+    static const char* engine_name(Engine engine);
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "../../../common/inc/memorymap.hpp"
+#include "computer.hpp"
+#include "input_log.hpp"
+#include "memory.hpp"
+#include "paged_memory.hpp"
+#include "screen.hpp"
+#include "snapshot.hpp"
+
+// Memory bus and devices of the emulated machine (everything except the CPU cores).
+// Cores attach to the bus with Computer::attach_memory(machine.memory).
+// Rom and main memory are copy-on-write pages from an ImageCache, so machines loaded with the
+// same image share their read-only and unmodified pages.
+class Machine {
+private:
+    ImageCache& _cache;
+    MemoryDevicePointer _rom;
+    MemoryDevicePointer _ram;
+    MemoryDevicePointer _keyboard;
+    std::shared_ptr<const Snapshot> _epoch; // last snapshot taken or restored
+
+public:
+    // bus pages [first_page, end_page) a device is mapped at, e.g. to total Computer::PageAccesses by
+    // device (the io page holds several devices and counts as one)
+    struct Region {
+        const char* name;
+        size_t first_page;
+        size_t end_page;
+    };
+
+    static constexpr size_t ROM_ADDRESS = 0x0000;
+    static constexpr size_t ROM_SIZE = 0x0100;
+    static constexpr size_t RAM_ADDRESS = 0x0100;
+    static constexpr size_t IO_ADDRESS = 0xDF00;
+    static constexpr size_t IO_SIZE = 0x0100;
+    static constexpr size_t WAIT_ADDRESS = 0xDF00;
+    static constexpr size_t KEYBOARD_ADDRESS = 0xDF01;
+    static constexpr size_t LOCK_ADDRESS = 0xDFF0;
+    static constexpr size_t LOCK_COUNT = 0x10;
+
+    Screen screen;
+    MemoryDevicePointer memory;
+
+    Machine(const Machine&) = delete;
+    Machine(Machine&&) = delete;
+
+    Machine(ImageCache& cache = ImageCache::global());
+
+    // copy a program image onto the bus (rom and main memory pages are shared through the cache)
+    void load(const MemoryMap& map);
+
+    // queue of keys read from the keyboard port (push a key, then wake the cores)
+    KeyboardDevice& keyboard();
+    // mark the input ports on a log, so a core recording to it logs their reads
+    void add_input_ports(InputLog& log) const;
+    // the devices on the bus, by address
+    std::vector<Region> regions() const;
+
+    // save the cores and the writable devices (the cores must be stopped)
+    // rom is not saved, so restore onto a machine loaded with the same image
+    // an incremental snapshot only saves the chunks written since the last snapshot taken or restored
+    std::shared_ptr<Snapshot> snapshot(const std::vector<Computer*>& cores, bool incremental = false);
+    // return the devices and cores to a snapshot (the cores must be stopped)
+    // if the last snapshot taken or restored is the snapshot or was based on it, only the chunks written since are copied
+    void restore(const std::shared_ptr<const Snapshot>& snapshot, const std::vector<Computer*>& cores);
+};
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <cstdint>
+#include <deque>
 #include <iostream>
 #include <memory>
 #include <ranges>
@@ -9,6 +12,16 @@
 #include "../../../common/inc/memorymap.hpp"
 #include "spinlock.hpp"
 
+constexpr size_t MEMORY_PAGE_SIZE = 0x100;
+using MemoryPage = std::array<uint8_t, MEMORY_PAGE_SIZE>;
+
+// Saved contents of up to one page of a device, at a bus address.
+struct MemoryChunk {
+    size_t address;
+    size_t size;
+    MemoryPage data;
+};
+
 enum class Endian {
     LITTLE,
     BIG
@@ -53,6 +66,15 @@ public:
     virtual MemoryResult write(size_t address, uint8_t value);
     virtual MemoryResult read(size_t address) const;
 
+    // Snapshot support. Devices with state save it as chunks at bus address base + device address,
+    // and remember which chunks were written since the last clean() so a snapshot can save only those.
+    virtual void save(size_t base, std::vector<MemoryChunk>& chunks, bool dirty_only) const;
+    // append the bus addresses of the chunks written since the last clean()
+    virtual void dirty(size_t base, std::vector<size_t>& addresses) const;
+    virtual void clean();
+    // copy saved bytes back into the device (without marking them written)
+    virtual void restore(size_t address, const uint8_t* data, size_t size);
+
     void debug_fill(size_t size, uint8_t value);
 
     template <Endian E, std::forward_iterator It>
@@ -62,7 +84,7 @@ public:
         const size_t n = std::numeric_limits<T>::digits / 8;
         const size_t size = this->size();
         for (auto it = begin; it != end; ++it) {
-            if (address + n >= size) {
+            if (address + n > size) {
                 std::cerr << "MemoryDevice::debug_write(): warning: data truncated, past end of memory.\n";
                 return;
             }
@@ -155,14 +177,23 @@ public:
     void debug_write(size_t address, uint8_t value) override;
     MemoryResult read(size_t address) const override;
     MemoryResult write(size_t address, uint8_t value) override;
+
+    void save(size_t base, std::vector<MemoryChunk>& chunks, bool dirty_only) const override;
+    void dirty(size_t base, std::vector<size_t>& addresses) const override;
+    void clean() override;
+    void restore(size_t address, const uint8_t* data, size_t size) override;
 };
 
 class BufferMemoryDevice : public MemoryDevice {
 protected:
     const size_t _size;
     std::unique_ptr<uint8_t[]> data;
+    std::vector<bool> written; // per page, since the last clean()
+    std::vector<size_t> written_pages; // the pages set in written, so dirty() and clean() don't scan them all
     mutable MSSpinLock lock;
 
+    void mark_written(size_t page);
+
 public:
     BufferMemoryDevice(size_t size, Access access);
 
@@ -170,4 +201,55 @@ public:
     void debug_write(size_t address, uint8_t value) override;
     MemoryResult read(size_t address) const override;
     MemoryResult write(size_t address, uint8_t value) override;
+
+    void save(size_t base, std::vector<MemoryChunk>& chunks, bool dirty_only) const override;
+    void dirty(size_t base, std::vector<size_t>& addresses) const override;
+    void clean() override;
+    void restore(size_t address, const uint8_t* data, size_t size) override;
+};
+
+// Memory device made of atomic test-and-set cells, used as guest lock primitives.
+// Reading a cell returns its value and sets it to 1 in one atomic operation; writing stores the value.
+class TestAndSetDevice : public MemoryDevice {
+private:
+    const size_t _size;
+    std::unique_ptr<std::atomic_uint8_t[]> cells;
+
+public:
+    TestAndSetDevice(size_t size);
+
+    size_t size() const override;
+    void debug_write(size_t address, uint8_t value) override;
+    MemoryResult read(size_t address) const override;
+    MemoryResult write(size_t address, uint8_t value) override;
+
+    // the cells are few and change constantly, so they are always saved
+    void save(size_t base, std::vector<MemoryChunk>& chunks, bool dirty_only) const override;
+    void dirty(size_t base, std::vector<size_t>& addresses) const override;
+    void restore(size_t address, const uint8_t* data, size_t size) override;
+};
+
+// Write-only register that halts the writing core. Writing n halts it for n * Computer::WAIT_UNIT
+// cycles, or until an event arrives when n is 0.
+class WaitDevice : public MemoryDevice {
+public:
+    WaitDevice();
+
+    size_t size() const override;
+    MemoryResult write(size_t address, uint8_t value) override;
+};
+
+// Read-only input port holding a queue of key codes. Reading returns the next key, or 0 if there is none.
+class KeyboardDevice : public MemoryDevice {
+private:
+    mutable std::deque<uint8_t> keys;
+    mutable MSSpinLock lock;
+
+public:
+    KeyboardDevice();
+
+    size_t size() const override;
+    MemoryResult read(size_t address) const override;
+
+    void push(uint8_t key);
 };
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "computer.hpp"
+#include "machine.hpp"
+
+// Serves live metrics of running cores in the Prometheus text format on a Unix domain socket, from a
+// thread of its own. Every connection gets the current values and is closed; a client that sends an
+// HTTP request gets an HTTP response, so `curl --unix-socket` and HTTP scrapers work too.
+// The thread only reads what the cores publish with relaxed atomics (Computer::peek_cycle(),
+// Computer::peek_statistics(), MSSpinLock::waits() and the page accesses the server attaches to every
+// core), so serving never waits on a core or slows it. Rates are over the last SAMPLE_PERIOD.
+// The cores must outlive the server.
+class MetricsServer {
+public:
+    static constexpr std::chrono::milliseconds SAMPLE_PERIOD { 1000 };
+
+private:
+    struct Sample {
+        std::chrono::steady_clock::time_point time;
+        std::vector<uint64_t> cycles; // by core
+        std::vector<uint64_t> instructions;
+    };
+
+    const std::string _path;
+    const std::vector<Computer*> _cores;
+    const std::vector<Machine::Region> _regions;
+    std::vector<std::unique_ptr<Computer::PageAccesses>> _accesses; // by core
+    const std::chrono::steady_clock::time_point _start;
+    int _socket;
+    int _stop_pipe[2];
+    // only used by the thread
+    Sample _previous;
+    Sample _last;
+    std::thread _thread;
+
+    Sample _sample() const;
+    std::string _render() const;
+    void _serve(int connection) const;
+    void _worker();
+
+public:
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer(MetricsServer&&) = delete;
+
+    // listen on a socket at path (replacing a stale socket there) and start serving
+    // throws std::runtime_error if the socket can't be created
+    MetricsServer(const std::string& path, const std::vector<Computer*>& cores, const std::vector<Machine::Region>& regions);
+    // stop serving, detach from the cores and remove the socket
+    ~MetricsServer();
+};
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "memory.hpp"
+#include "spinlock.hpp"
+
+// Deduplicating store of immutable memory pages.
+// Identical pages interned through the same cache share one copy, so instances loaded from the
+// same image only pay for the pages they write to.
+class ImageCache {
+private:
+    std::mutex _mutex;
+    std::unordered_map<std::string, std::weak_ptr<const MemoryPage>> _pages;
+    size_t _inserts_since_purge;
+
+    void _purge();
+
+public:
+    ImageCache();
+
+    // process-wide cache used by default
+    static ImageCache& global();
+
+    // return the shared copy of a page with the same contents
+    std::shared_ptr<const MemoryPage> intern(const MemoryPage& page);
+};
+
+// Copy-on-write memory made of pages from an ImageCache.
+// Pages stay shared until the first write (or differing debug write) gives the device a private copy.
+class PagedMemoryDevice : public MemoryDevice {
+private:
+    const size_t _size;
+    std::vector<std::shared_ptr<const MemoryPage>> pages;
+    std::vector<bool> owned;
+    std::vector<bool> written; // since the last clean()
+    std::vector<size_t> written_pages; // the pages set in written, so dirty() and clean() don't scan them all
+    mutable MSSpinLock lock;
+
+    MemoryPage& _own(size_t page);
+    void _mark_written(size_t page);
+
+public:
+    PagedMemoryDevice(size_t size, Access access, ImageCache& cache = ImageCache::global());
+
+    size_t size() const override;
+    void debug_write(size_t address, uint8_t value) override;
+    MemoryResult read(size_t address) const override;
+    MemoryResult write(size_t address, uint8_t value) override;
+
+    // read-only devices are not saved (a snapshot is restored onto a machine loaded with the same image)
+    void save(size_t base, std::vector<MemoryChunk>& chunks, bool dirty_only) const override;
+    void dirty(size_t base, std::vector<size_t>& addresses) const override;
+    void clean() override;
+    void restore(size_t address, const uint8_t* data, size_t size) override;
+
+    // replace a whole page with a shared page
+    void share(size_t page, const std::shared_ptr<const MemoryPage>& data);
+    // copy the current contents of a page
+    MemoryPage page(size_t page) const;
+    // number of pages holding a private copy
+    size_t owned_pages() const;
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+
+#include "../../../common/inc/symbols.hpp"
+#include "../../../common/inc/encoding.hpp"
+
+// Counts how many times every instruction address is executed, and how many instructions of each
+// class run. Every instruction takes five cycles, so the counts are also where the cycles went
+// (cycles spent halted aren't counted). The core counts into it directly as it decodes each
+// instruction (see Computer::attach_profiler()): two increments with no branches, in either engine,
+// cheap enough to leave on.
+class Profiler {
+public:
+    enum class Class : uint8_t {
+        ALU,
+        ALU_IMMEDIATE,
+        LOAD,
+        STORE,
+        JUMP, // including conditional jumps and returns
+        CALL,
+    };
+
+    static constexpr size_t CLASS_COUNT = 6;
+
+private:
+    // class by the top three bits of the instruction (format and, for M and C, the store / save ra bit)
+    static constexpr Class CLASSES[8] {
+        Class::ALU, Class::ALU, Class::ALU_IMMEDIATE, Class::ALU_IMMEDIATE,
+        Class::LOAD, Class::STORE, Class::JUMP, Class::CALL,
+    };
+
+    std::array<uint64_t, 0x10000> _counts;
+    std::array<uint64_t, CLASS_COUNT> _classes;
+
+public:
+    Profiler();
+
+    void clear();
+    // add the counts of another profiler (e.g. of another core)
+    void merge(const Profiler& other);
+
+    uint64_t count(uint16_t pc) const;
+    uint64_t count(Class c) const;
+    uint64_t total() const;
+
+    static const char* class_name(Class c);
+
+    // the top most executed addresses labelled with the closest symbol before them, the top labels
+    // (counting every address up to the next label), and the per-class counts
+    void report(std::ostream& out, const SymbolTable& symbols, size_t top = 20) const;
+
+    // count an instruction (called by the core)
+    void executed(uint16_t pc, uint16_t instruction) {
+        ++_counts[pc];
+        ++_classes[static_cast<size_t>(CLASSES[instruction >> 13])];
+    }
+};
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "computer.hpp"
+#include "memory.hpp"
+
+// Saved state of a machine: the state of every core and the contents of its writable devices.
+// An incremental snapshot only holds the chunks written since its base was taken or restored.
+struct Snapshot {
+    std::vector<Computer::State> cores;
+    std::vector<MemoryChunk> chunks; // sorted by address
+    std::shared_ptr<const Snapshot> base; // null for a full snapshot
+
+    // find the saved contents of the chunk at an address, looking through the bases
+    const MemoryChunk* find(size_t address) const;
+    // bus addresses of every saved chunk (the chunks of the full snapshot at the root)
+    std::vector<size_t> addresses() const;
+    // bytes held by this snapshot, not counting its bases
+    size_t bytes() const;
+
+    // save as a full snapshot
+    void write(const std::string& filename) const;
+    void read(const std::string& filename);
+};
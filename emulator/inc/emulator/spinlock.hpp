@@ -1,21 +1,37 @@
 #pragma once
 
 #include <atomic>
+#include <cstdint>
+#include <optional>
 
 // Spinlock that can be acquired as master or slave.
 // Slaves will not be able to acquire the lock until all masters release the lock.
 class MSSpinLock {
+public:
+    // acquisitions that had to wait, over all locks in the process
+    struct Waits {
+        uint64_t count;
+        uint64_t ns;
+    };
+
 private:
     friend class MSSpinLockGuard;
 
+    static std::atomic_uint64_t _wait_count;
+    static std::atomic_uint64_t _wait_ns;
+
     std::atomic_uint64_t _master;
     std::atomic_flag _lock;
+    std::atomic_uint32_t _waiters; // threads blocked in a wait, so uncontended releases skip the notify
 
-    void _acquire();
+    void _acquire(std::optional<uint64_t>& wait_begin); // sets wait_begin (if unset) when it has to wait
     void _release();
 
 public:
     MSSpinLock();
+
+    // read with relaxed atomics; uncontended acquisitions don't touch them
+    static Waits waits();
 };
 
 // Lock guard for MSSpinLock.
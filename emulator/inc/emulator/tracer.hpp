@@ -0,0 +1,107 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "computer.hpp"
+
+struct TraceCodec;
+
+// Instruction trace of one core, streamed to a file while it runs.
+// The tracer is a probe: the core's thread fills fixed-size records into a ring buffer, and a
+// background thread drains the ring into the file, encoding every record as the difference from
+// the previous one (usually 1-3 bytes). The core waits if the writer falls a full ring behind.
+// Only instructions inside the filter's pc range and cycle window are recorded.
+class Tracer: public Probe {
+public:
+    enum Flag : uint8_t {
+        REG = 1 << 0, // wrote reg
+        READ = 1 << 1, // loaded mem_value from address
+        WRITE = 1 << 2, // stored mem_value to address
+        RA = 1 << 3, // saved the return address ra to ra.l and ra.h (call, rcall, cbl, cbh, callret)
+    };
+
+    struct Record {
+        uint64_t cycle; // at the start of the instruction
+        uint16_t pc;
+        uint16_t instruction;
+        uint16_t address;
+        uint16_t ra;
+        uint8_t flags;
+        uint8_t reg;
+        uint8_t reg_value;
+        uint8_t mem_value;
+        uint8_t sr; // after the instruction
+    };
+
+    struct Filter {
+        uint16_t first_pc = 0;
+        uint16_t last_pc = 0xFFFF; // inclusive
+        uint64_t begin_cycle = 0;
+        uint64_t end_cycle = std::numeric_limits<uint64_t>::max(); // exclusive
+    };
+
+    static constexpr size_t RING_SIZE = 1 << 16;
+
+private:
+    Computer& _core;
+    const Filter _filter;
+    std::ofstream _file;
+    std::unique_ptr<TraceCodec> _codec;
+    std::unique_ptr<Record[]> _ring;
+
+    // producer (core thread) side
+    alignas(64) std::atomic_uint64_t _head;
+    uint64_t _tail_seen;
+    Record _current; // instruction being executed
+    bool _tracing_current;
+
+    // consumer (writer thread) side
+    alignas(64) std::atomic_uint64_t _tail;
+    std::atomic_bool _closing;
+    std::thread _writer;
+    bool _write_failed;
+
+    void _finish(const Computer::State& state);
+    void _push(const Record& record);
+    void _write_worker();
+
+public:
+    Tracer(const Tracer&) = delete;
+    Tracer(Tracer&&) = delete;
+
+    // start tracing the core into a new file (throws if it can't be created)
+    Tracer(Computer& core, const std::string& filename, const Filter& filter);
+    // same as close()
+    ~Tracer();
+
+    // stop tracing and write out the rest of the trace (throws if writing failed)
+    // the instruction in progress is dropped if the core isn't stopped at an instruction boundary
+    void close();
+
+    // records written so far (by the core, not necessarily to the file yet)
+    uint64_t records() const;
+
+    bool instruction(const Computer::State& state) override;
+    bool access(const Computer::State& state, uint16_t address, bool write) override;
+};
+
+// Reads back a file written by Tracer.
+class TraceReader {
+private:
+    std::ifstream _file;
+    std::unique_ptr<TraceCodec> _codec;
+
+public:
+    // throws if the file isn't a trace
+    TraceReader(const std::string& filename);
+    ~TraceReader();
+
+    // read the next record, returns false at the end of the trace
+    bool next(Tracer::Record& record);
+};
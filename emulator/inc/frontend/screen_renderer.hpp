@@ -5,6 +5,7 @@
 #include <SFML/Window.hpp>
 #include <SFML/Graphics.hpp>
 #include <string>
+#include <vector>
 
 #include "../emulator/memory.hpp"
 #include "../emulator/screen.hpp"
@@ -27,6 +28,21 @@
 // F: DARK GRAY
 
 class ScreenRenderer {
+public:
+    static constexpr double FRAME_BUDGET = 1.0 / 60; // seconds, the window is synced to a 60Hz display
+
+    // CPU time of one draw() by phase, in seconds
+    struct FrameTime {
+        double read = 0; // copying the screen memory
+        double expand = 0; // expanding characters into pixels
+        double upload = 0; // updating the texture from the image
+        double draw = 0; // drawing the sprite to the target
+
+        double total() const {
+            return read + expand + upload + draw;
+        }
+    };
+
 private:
     static constexpr unsigned int CHAR_HEIGHT = 8;
     static const uint8_t FONT[];
@@ -53,11 +69,17 @@ private:
 
     Screen *screen;
 
+    std::vector<uint8_t> cells; // copy of the screen memory, character and color per cell
     sf::Image image;
     sf::Texture texture;
     sf::Sprite sprite;
 
+    FrameTime last_frame;
+    uint64_t frames = 0;
+    uint64_t frames_over_budget = 0;
+
     void draw_char(unsigned int x, unsigned int y, const uint8_t* bitmap, const sf::Color& foreground, const sf::Color& background);
+    void read_screen();
     void draw_screen();
     void window_handler(unsigned int scale, unsigned int framerate);
 
@@ -73,6 +95,11 @@ public:
         float scale = 1.0f
     );
 
-    void draw(sf::RenderWindow& window);
+    void draw(sf::RenderTarget& target);
+
+    const FrameTime& get_last_frame() const;
+    uint64_t get_frames() const;
+    // frames whose draw() alone took longer than FRAME_BUDGET
+    uint64_t get_frames_over_budget() const;
 };
 
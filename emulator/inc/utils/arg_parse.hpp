@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 #include <queue>
 #include <unordered_map>
 #include <string>
@@ -31,4 +32,8 @@ public:
     /// Checks if there are remaining flags or arguments that have not been
     /// taken.
     bool has_remaining();
+
+    /// Parses an option value as an unsigned number, decimal or hexadecimal
+    /// after 0x. Returns nothing if the value is not a number or is too large.
+    static std::optional<uint64_t> parse_number(const std::string& str);
 };
@@ -0,0 +1,66 @@
+# 16-bit arithmetic: steps x = x * 75 + 74 (mod 0x10000) 10000 times from x = 1, multiplying by
+# shifting and adding, and leaves the 16-bit sum of the x values at 0x0200.
+
+reset:
+    *mov sp 0
+    *mov fp 0
+    *mov ge 0x0300
+    call ge
+    *mov ge 0xDF00
+    *mov gb 0
+reset_l0:
+    st gb ge 0
+    rjmp reset_l0
+
+.move 0x0300
+main:
+    sub sp 2                                # save return address (ra.l is a scratch register below)
+    sts ra.l 0
+    sts ra.h 1
+    *mov gh 1                               # x
+    *mov gc 0                               # sum (gd:gc)
+    *mov gd 0
+    *mov ga 40                              # 40 * 250 steps
+main_l0:
+    *mov gb 250
+main_l1:
+    mov ge.l gh.l                           # gg = x * 75: add ge to gg for every bit of gf
+    mov ge.h gh.h
+    *mov gf 75
+    *mov gg.l 0
+    *mov gg.h 0
+main_l2:
+    mov ra.l gf.l
+    and ra.l 1
+    rjmp z main_l3
+    add gg.l ge.l
+    adc gg.h ge.h
+main_l3:
+    add ge.l ge.l                           # ge <<= 1
+    adc ge.h ge.h
+    shr gf.l 1                              # gf >>= 1
+    mov ra.l gf.h
+    shl ra.l 7
+    or gf.l ra.l
+    shr gf.h 1
+    mov ra.l gf.l                           # until gf == 0
+    or ra.l gf.h
+    rjmp nz main_l2
+    *mov ra.l 74                            # x = gg + 74
+    mov gh.l gg.l
+    mov gh.h gg.h
+    add gh.l ra.l
+    adc gh.h 0
+    add gc gh.l                             # sum += x
+    adc gd gh.h
+    sub gb 1
+    *jmp nz main_l1 gf                      # (gf is free again)
+    sub ga 1
+    *jmp nz main_l0 gf
+    *mov ge 0x0200                          # checksum
+    st gc ge 0
+    st gd ge 1
+    lds ra.l 0
+    lds ra.h 1
+    add sp 2
+    ret
@@ -0,0 +1,95 @@
+# memset and memcpy: 32 rounds of filling a 4 KiB buffer at 0x4000 with the round number, marking
+# byte [round] with 0xFF and copying the buffer to 0x6000. The checksum at 0x0200 adds up bytes
+# [round] and [0x0FFF] of every copy and all the bytes of the last one.
+
+reset:
+    *mov sp 0
+    *mov fp 0
+    *mov ge 0x0300
+    call ge
+    *mov ge 0xDF00
+    *mov gb 0
+reset_l0:
+    st gb ge 0
+    rjmp reset_l0
+
+.move 0x0300
+main:
+    sub sp 2
+    sts ra.l 0
+    sts ra.h 1
+    *mov gg 0                               # checksum
+    *mov ga 0                               # round
+    *mov gc 32                              # rounds left
+main_l0:
+    *mov ge 0x4000                          # memset(0x4000, round, 16 pages)
+    mov gb ga
+    *mov gd 16
+    *call memset gh
+    *mov ge 0x4000                          # mark byte [round]
+    mov ge.l ga
+    *mov gb 0xFF
+    st gb ge 0
+    *mov ge 0x6000                          # memcpy(0x6000, 0x4000, 16 pages)
+    *mov gf 0x4000
+    *mov gd 16
+    *call memcpy gh
+    *mov ge 0x6000                          # checksum += copy[round] + copy[0x0FFF]
+    mov ge.l ga
+    ld gb ge 0
+    add gg.l gb
+    adc gg.h 0
+    *mov ge 0x6FFF
+    ld gb ge 0
+    add gg.l gb
+    adc gg.h 0
+    add ga 1
+    sub gc 1
+    *jmp nz main_l0 gh
+    *mov ge 0x6000                          # checksum += every byte of the last copy
+    *mov gd 0x70
+main_l1:
+    ld gb ge 0
+    add gg.l gb
+    adc gg.h 0
+    add ge.l 1
+    adc ge.h 0
+    cmp ge.h gd
+    rjmp nz main_l1
+    *mov ge 0x0200
+    st gg.l ge 0
+    st gg.h ge 1
+    lds ra.l 0
+    lds ra.h 1
+    add sp 2
+    ret
+
+# fill gd pages from ge (page aligned) with gb, clobbers ge and gd
+memset:
+    add gd ge.h                             # end page
+memset_l0:
+    st gb ge 0
+    st gb ge 1
+    st gb ge 2
+    st gb ge 3
+    add ge.l 4
+    adc ge.h 0
+    cmp ge.h gd
+    rjmp nz memset_l0
+    ret
+
+# copy gd pages from gf to ge (both page aligned), clobbers gb, gd, ge and gf
+memcpy:
+    add gd ge.h                             # end page
+memcpy_l0:
+    ld gb gf 0
+    st gb ge 0
+    ld gb gf 1
+    st gb ge 1
+    add ge.l 2
+    adc ge.h 0
+    add gf.l 2
+    adc gf.h 0
+    cmp ge.h gd
+    rjmp nz memcpy_l0
+    ret
@@ -0,0 +1,56 @@
+# Call-heavy recursion: computes fib(21) = 10946 with the naive doubly recursive function
+# (35421 calls), leaving the result at 0x0200 as the checksum.
+
+reset:
+    *mov sp 0
+    *mov fp 0
+    *mov ge 0x0300
+    call ge
+    *mov ge 0xDF00
+    *mov gb 0
+reset_l0:
+    st gb ge 0
+    rjmp reset_l0
+
+.move 0x0300
+main:
+    sub sp 2
+    sts ra.l 0
+    sts ra.h 1
+    *mov gb 21
+    rcall fib
+    *mov ge 0x0200
+    st gg.l ge 0
+    st gg.h ge 1
+    lds ra.l 0
+    lds ra.h 1
+    add sp 2
+    ret
+
+# gg = fib(gb), clobbers gb
+fib:
+    cmp gb 2
+    rjmp c fib_l0
+    mov gg.l gb                             # fib(0) = 0, fib(1) = 1
+    *mov gg.h 0
+    ret
+fib_l0:
+    sub sp 5
+    sts ra.l 0
+    sts ra.h 1
+    sts gb 2
+    sub gb 1                                # fib(n - 1)
+    rcall fib
+    sts gg.l 3
+    sts gg.h 4
+    lds gb 2                                # fib(n - 2)
+    sub gb 2
+    rcall fib
+    lds gb 3
+    add gg.l gb
+    lds gb 4
+    adc gg.h gb
+    lds ra.l 0
+    lds ra.h 1
+    add sp 5
+    ret
@@ -0,0 +1,75 @@
+# Screen fill: draws 25 frames of a diagonal 'A' to 'P' pattern over all 80x50 character cells
+# of the screen at 0xE000, in a different color each frame. The checksum at 0x0200 is a Fletcher
+# sum (as in sort.s) over the 8000 bytes of the last frame.
+
+reset:
+    *mov sp 0
+    *mov fp 0
+    *mov ge 0x0300
+    call ge
+    *mov ge 0xDF00
+    *mov gb 0
+reset_l0:
+    st gb ge 0
+    rjmp reset_l0
+
+.move 0x0300
+main:
+    sub sp 4
+    sts ra.l 0
+    sts ra.h 1
+    *mov gb 0                               # frame
+    sts gb 2
+    *mov gb 25                              # frames left
+    sts gb 3
+    *mov gh.l 0x41                          # 'A'
+main_l0:
+    *mov ge 0xE000
+    lds ga 2                                # first character and color of the frame
+    mov gd ga
+    *mov gf.h 50                            # rows left
+main_l1:
+    *mov gc 80                              # cells left in the row
+main_l2:
+    mov gb ga
+    and gb 15
+    add gb gh.l
+    st gb ge 0
+    st gd ge 1
+    add ga 1
+    add ge.l 2
+    adc ge.h 0
+    sub gc 1
+    rjmp nz main_l2
+    add ga 3                                # next row starts further along the pattern
+    sub gf.h 1
+    rjmp nz main_l1
+    lds gb 2
+    add gb 1
+    sts gb 2
+    lds gb 3
+    sub gb 1
+    sts gb 3
+    rjmp nz main_l0
+    *mov ge 0xE000
+    *mov gh 0                               # checksum
+    *mov gf.h 50
+main_l3:
+    *mov gc 160
+main_l4:
+    ld gb ge 0
+    add gh.l gb
+    add gh.h gh.l
+    add ge.l 1
+    adc ge.h 0
+    sub gc 1
+    rjmp nz main_l4
+    sub gf.h 1
+    rjmp nz main_l3
+    *mov ge 0x0200
+    st gh.l ge 0
+    st gh.h ge 1
+    lds ra.l 0
+    lds ra.h 1
+    add sp 4
+    ret
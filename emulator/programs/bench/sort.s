@@ -0,0 +1,88 @@
+# Sorting: 32 rounds of filling 128 bytes at 0x4000 from a xorshift16 generator and insertion
+# sorting them. The checksum at 0x0200 is a running Fletcher sum (low byte: sum of the bytes, high
+# byte: sum of the low byte) over every sorted array, mod 256.
+
+reset:
+    *mov sp 0
+    *mov fp 0
+    *mov ge 0x0300
+    call ge
+    *mov ge 0xDF00
+    *mov gb 0
+reset_l0:
+    st gb ge 0
+    rjmp reset_l0
+
+.move 0x0300
+main:
+    sub sp 3
+    sts ra.l 0
+    sts ra.h 1
+    *mov gb 32                              # rounds left
+    sts gb 2
+    *mov gg 1                               # generator state
+    *mov gh 0                               # checksum
+    *mov gd 128                             # array size
+main_l0:
+    *mov ge 0x4000
+main_l1:
+    mov gb gg.h                             # gg ^= gg << 7
+    shl gb 7
+    mov gc gg.l
+    shr gc 1
+    or gb gc
+    mov gc gg.l
+    shl gc 7
+    xor gg.h gb
+    xor gg.l gc
+    mov gb gg.h                             # gg ^= gg >> 9
+    shr gb 1
+    xor gg.l gb
+    xor gg.h gg.l                           # gg ^= gg << 8
+    st gg.h ge 0
+    add ge.l 1
+    cmp ge.l gd
+    rjmp nz main_l1
+    rcall sort
+    *mov ge 0x4000
+main_l2:
+    ld gb ge 0
+    add gh.l gb
+    add gh.h gh.l
+    add ge.l 1
+    cmp ge.l gd
+    rjmp nz main_l2
+    lds gb 2
+    sub gb 1
+    sts gb 2
+    *jmp nz main_l0 gf
+    *mov ge 0x0200
+    st gh.l ge 0
+    st gh.h ge 1
+    lds ra.l 0
+    lds ra.h 1
+    add sp 3
+    ret
+
+# insertion sort the gd bytes at 0x4000 (unsigned), clobbers ga, gb, gc and ge
+sort:
+    *mov ge 0x4000
+    *mov gc 1                               # i
+sort_l0:
+    mov ge.l gc                             # j = i
+    ld gb ge 0                              # key = a[i]
+sort_l1:
+    cmp ge.l 0
+    rjmp z sort_l2
+    ld ga ge -1
+    cmp gb ga
+    rjmp c sort_l2                          # until a[j - 1] <= key
+    st ga ge 0                              # a[j] = a[j - 1]
+    sub ge.l 1
+    rjmp sort_l1
+sort_l2:
+    st gb ge 0                              # a[j] = key
+    add gc 1
+    cmp gc gd
+    rjmp nz sort_l0
+    ret
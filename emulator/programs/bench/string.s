@@ -0,0 +1,118 @@
+# String processing: builds a 255 character string of random lowercase words at 0x4000, then
+# 200 times copies it to 0x4100 in upper case and scans the copy, hashing it (rotate left and xor
+# each character) and counting its words. The checksum at 0x0200 is the hash plus the word count.
+
+reset:
+    *mov sp 0
+    *mov fp 0
+    *mov ge 0x0300
+    call ge
+    *mov ge 0xDF00
+    *mov gb 0
+reset_l0:
+    st gb ge 0
+    rjmp reset_l0
+
+.move 0x0300
+main:
+    sub sp 3
+    sts ra.l 0
+    sts ra.h 1
+    *mov gg 1                               # generator state
+    *mov ge 0x4000
+    *mov ga 0x61                            # 'a'
+    *mov gd 0xFF                            # string length
+main_l0:
+    mov gb gg.h                             # xorshift16
+    shl gb 7
+    mov gc gg.l
+    shr gc 1
+    or gb gc
+    mov gc gg.l
+    shl gc 7
+    xor gg.h gb
+    xor gg.l gc
+    mov gb gg.h
+    shr gb 1
+    xor gg.l gb
+    xor gg.h gg.l
+    mov gb gg.h                             # 26 of 32 values are letters, the rest spaces
+    and gb 31
+    cmp gb 26
+    rjmp c main_l1
+    add gb ga
+    rjmp main_l2
+main_l1:
+    *mov gb 0x20
+main_l2:
+    st gb ge 0
+    add ge.l 1
+    cmp ge.l gd
+    rjmp nz main_l0
+    *mov gb 0
+    st gb ge 0
+    *mov gg 0                               # word count
+    *mov gh 0                               # hash
+    *mov gb 200                             # rounds left
+    sts gb 2
+main_l3:
+    *mov ge 0x4000
+    *mov gf 0x4100
+    rcall upper
+    *mov ge 0x4100
+    rcall words
+    lds gb 2
+    sub gb 1
+    sts gb 2
+    rjmp nz main_l3
+    add gh.l gg.l
+    adc gh.h gg.h
+    *mov ge 0x0200
+    st gh.l ge 0
+    st gh.h ge 1
+    lds ra.l 0
+    lds ra.h 1
+    add sp 3
+    ret
+
+# copy the string at ge to gf in upper case (neither may cross a page), clobbers ga, gb, gd, ge and gf
+upper:
+    *mov ga 0x61                            # 'a'
+    *mov gd 0xDF                            # ~0x20
+upper_l0:
+    ld gb ge 0
+    cmp gb ga
+    rjmp nc upper_l1
+    and gb gd
+upper_l1:
+    st gb gf 0
+    add ge.l 1
+    add gf.l 1
+    cmp gb 0
+    rjmp nz upper_l0
+    ret
+
+# hash the string at ge into gh and add its words (runs of non-spaces) to gg, clobbers ga, gb, gd and ge
+words:
+    *mov gd 0x20                            # ' '
+    *mov ga 1                               # the last character was a space
+words_l0:
+    ld gb ge 0
+    cmp gb 0
+    ret z
+    add gh.l gh.l                           # gh = rotate left(gh) ^ character
+    adc gh.h gh.h
+    adc gh.l 0
+    xor gh.l gb
+    add ge.l 1
+    cmp gb gd
+    rjmp z words_l1
+    cmp ga 0
+    rjmp z words_l0
+    add gg.l 1                              # a word starts
+    adc gg.h 0
+    *mov ga 0
+    rjmp words_l0
+words_l1:
+    *mov ga 1
+    rjmp words_l0
@@ -3,11 +3,14 @@
 # Procedure:
 #     1. set up the stack
 #     2. call 0x0300 (no arguments)
-#     3. halt
+#     3. halt (wait for events forever)
 reset:
-    mov sp 0
-    mov fp 0
-    mov ge 0x0300
+    *mov sp 0
+    *mov fp 0
+    *mov ge 0x0300
     call ge
+    *mov ge 0xDF00
+    *mov gb 0
 reset_l0:
-    rjmp reset_l0
\ No newline at end of file
+    st gb ge 0
+    rjmp reset_l0
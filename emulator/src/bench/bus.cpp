@@ -0,0 +1,123 @@
+#include "bus.hpp"
+#include "../../inc/emulator/machine.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <format>
+#include <thread>
+
+static constexpr size_t DEVICE_COUNTS[] { 1, 4, 16, 64, 256 };
+static constexpr const char* PATTERN_NAMES[] { "sequential", "random", "screen" };
+
+BusBench::BusBench() :
+    _random(1)
+{
+    const size_t screen_size = Machine().screen.memory().size();
+    for (size_t i = 0; i < ADDRESS_SPACE; ++i) {
+        _addresses[SEQUENTIAL].push_back(i);
+        _addresses[RANDOM].push_back(_random());
+        _addresses[SCREEN].push_back(ADDRESS_SPACE - screen_size + i % screen_size);
+    }
+}
+
+// An interface device dividing the address space between equal buffer devices.
+MemoryDevicePointer BusBench::_interface(size_t devices) {
+    MemoryDevicePointer interface = new InterfaceDevice(MemoryDevice::Access::READ_WRITE);
+    const size_t size = ADDRESS_SPACE / devices;
+    for (size_t i = 0; i < devices; ++i)
+        interface.get<InterfaceDevice>().add_device(i * size, new BufferMemoryDevice(size, MemoryDevice::Access::READ_WRITE));
+    return interface;
+}
+
+void BusBench::_dispatch(Bench& bench) {
+    for (const size_t devices: DEVICE_COUNTS) {
+        const MemoryDevicePointer interface = _interface(devices);
+        for (int pattern = 0; pattern < PATTERN_COUNT; ++pattern) {
+            const std::vector<uint16_t>& addresses = _addresses[pattern];
+            bench.run(std::format("bus/interface/{}/read/{}", devices, PATTERN_NAMES[pattern]), "access", [&] (uint64_t n) {
+                for (uint64_t i = 0; i < n; ++i)
+                    Bench::keep(interface->read(addresses[i % ADDRESS_SPACE]).value);
+            });
+            bench.run(std::format("bus/interface/{}/write/{}", devices, PATTERN_NAMES[pattern]), "access", [&] (uint64_t n) {
+                for (uint64_t i = 0; i < n; ++i)
+                    interface->write(addresses[i % ADDRESS_SPACE], i);
+            });
+        }
+    }
+}
+
+void BusBench::_buffer(Bench& bench) {
+    BufferMemoryDevice buffer(ADDRESS_SPACE, MemoryDevice::Access::READ_WRITE);
+    const std::vector<uint16_t>& screen = _addresses[SCREEN];
+
+    for (const bool contended: { false, true }) {
+        // the contending thread sweeps the screen memory like the renderer
+        std::atomic_bool done = false;
+        std::thread reader;
+        if (contended) {
+            reader = std::thread([&] () {
+                for (size_t i = 0; !done.load(std::memory_order_relaxed); ++i)
+                    Bench::keep(buffer.read(screen[i % ADDRESS_SPACE]).value);
+            });
+        }
+
+        const char* name = contended ? "contended" : "uncontended";
+        for (int pattern = 0; pattern < PATTERN_COUNT; ++pattern) {
+            const std::vector<uint16_t>& addresses = _addresses[pattern];
+            bench.run(std::format("bus/buffer/{}/read/{}", name, PATTERN_NAMES[pattern]), "access", [&] (uint64_t n) {
+                for (uint64_t i = 0; i < n; ++i)
+                    Bench::keep(buffer.read(addresses[i % ADDRESS_SPACE]).value);
+            });
+            bench.run(std::format("bus/buffer/{}/write/{}", name, PATTERN_NAMES[pattern]), "access", [&] (uint64_t n) {
+                for (uint64_t i = 0; i < n; ++i)
+                    buffer.write(addresses[i % ADDRESS_SPACE], i);
+            });
+        }
+
+        done = true;
+        if (reader.joinable())
+            reader.join();
+    }
+}
+
+// The emulated machine's own bus (rom and main memory are paged, io and screen sit behind it).
+void BusBench::_machine(Bench& bench) {
+    Machine machine;
+    for (int pattern = 0; pattern < PATTERN_COUNT; ++pattern) {
+        const std::vector<uint16_t>& addresses = _addresses[pattern];
+        bench.run(std::format("bus/machine/read/{}", PATTERN_NAMES[pattern]), "access", [&] (uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i)
+                Bench::keep(machine.memory->read(addresses[i % ADDRESS_SPACE]).value);
+        });
+    }
+}
+
+void BusBench::_debug(Bench& bench) {
+    // a program image: 4K sections every 8K
+    MemoryMap map;
+    for (size_t address = 0; address < ADDRESS_SPACE; address += 0x2000) {
+        map.set_address(address);
+        for (size_t i = 0; i < 0x1000; ++i)
+            map.push_byte(_random());
+    }
+
+    for (const size_t devices: DEVICE_COUNTS) {
+        const MemoryDevicePointer interface = _interface(devices);
+        // whole passes: loading the 32K image or filling the address space
+        bench.run(std::format("bus/interface/{}/load", devices), "load", [&] (uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i)
+                interface->debug_write(map);
+        });
+        bench.run(std::format("bus/interface/{}/fill", devices), "fill", [&] (uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i)
+                interface->debug_fill(ADDRESS_SPACE, i);
+        });
+    }
+}
+
+void BusBench::run(Bench& bench) {
+    _dispatch(bench);
+    _buffer(bench);
+    _machine(bench);
+    _debug(bench);
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "../../inc/emulator/memory.hpp"
+#include "../../../common/inc/bench.hpp"
+
+// Microbenchmarks of the memory bus: InterfaceDevice dispatch over device tables of different
+// sizes, BufferMemoryDevice reads and writes with and without a thread reading it concurrently (as
+// the screen renderer does), and loading and filling memory through the debug interface.
+class BusBench {
+private:
+    enum Pattern {
+        SEQUENTIAL,
+        RANDOM,
+        SCREEN, // sequential over the screen memory at the top of the address space
+        PATTERN_COUNT
+    };
+
+    static constexpr size_t ADDRESS_SPACE = 0x10000;
+
+    std::mt19937 _random;
+    std::vector<uint16_t> _addresses[PATTERN_COUNT]; // one pass of each pattern
+
+    static MemoryDevicePointer _interface(size_t devices);
+    void _dispatch(Bench& bench);
+    void _buffer(Bench& bench);
+    void _machine(Bench& bench);
+    void _debug(Bench& bench);
+
+public:
+    BusBench();
+
+    void run(Bench& bench);
+};
@@ -0,0 +1,63 @@
+#include "farm.hpp"
+#include "../../inc/emulator/farm.hpp"
+#include "../../../common/inc/encoding.hpp"
+
+#include <algorithm>
+#include <format>
+#include <future>
+#include <thread>
+#include <vector>
+
+// 6-bit immediate fields
+static uint16_t immediate(int value) {
+    const uint16_t i = value & 0x3F;
+    return (i & *Encoding::IL_MASK) | (i << *Encoding::IH_SHIFT & *Encoding::IH_MASK);
+}
+
+// A loop at reset storing a counter across the zero page, so every machine writes its own pages.
+FarmBench::FarmBench() {
+    const int program[] {
+        // add gb, 1
+        *Encoding::FMT_IA << *Encoding::FMT_SHIFT | *ALUOp::ADD << *Encoding::O_SHIFT
+            | *Register::GB << *Encoding::X_SHIFT | immediate(1),
+        // st gb, [zpg + 0]
+        *Encoding::FMT_M << *Encoding::FMT_SHIFT | *Encoding::S_MASK | *AddrModeM::ZPG << *Encoding::M_SHIFT
+            | *Register::GB << *Encoding::X_SHIFT | immediate(0),
+        // jmp rel -6
+        *Encoding::FMT_C << *Encoding::FMT_SHIFT | *AddrModeC::REL << *Encoding::M_SHIFT
+            | *JumpCond::ALW << *Encoding::C_SHIFT | immediate(-3),
+    };
+    _image.set_address(0);
+    for (const uint16_t instruction: program) {
+        _image.push_byte(instruction >> 8);
+        _image.push_byte(instruction);
+    }
+}
+
+void FarmBench::run(Bench& bench) {
+    const size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<size_t> worker_counts;
+    for (size_t workers = 1; workers < threads; workers *= 2)
+        worker_counts.push_back(workers);
+    worker_counts.push_back(threads);
+
+    double single = 0; // median ns per job on one worker
+    for (const size_t workers: worker_counts) {
+        Farm farm(workers, SLICE);
+        if (!bench.run(std::format("farm/{}", workers), "job", [&] (uint64_t n) {
+            std::vector<std::future<Farm::Result>> results;
+            results.reserve(n);
+            for (uint64_t i = 0; i < n; ++i)
+                results.push_back(farm.submit({ _image, {}, JOB_CYCLES * (1 + i % 4) }));
+            for (auto& result: results)
+                Bench::keep(result.get().state.cycle);
+        }))
+            continue;
+        const double median = bench.results().back().median;
+        if (workers == 1)
+            single = median;
+        bench.metric("jobs/s", 1e9 / median);
+        if (single != 0)
+            bench.metric("speedup", single / median);
+    }
+}
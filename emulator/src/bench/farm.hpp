@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+
+#include "../../../common/inc/bench.hpp"
+#include "../../../common/inc/memorymap.hpp"
+
+// Throughput of the in-process farm: batches of jobs of uneven length run on 1, 2, 4, ... workers up
+// to the host's hardware threads, with a short time slice so jobs are sliced and stolen. Reports jobs
+// per second and the speedup over one worker, which should grow linearly with the workers.
+class FarmBench {
+private:
+    static constexpr uint64_t SLICE = 20000;
+    static constexpr uint64_t JOB_CYCLES = 50000; // jobs run 1 to 4 times this
+
+    MemoryMap _image;
+
+public:
+    FarmBench();
+
+    void run(Bench& bench);
+};
@@ -0,0 +1,121 @@
+#include "guest.hpp"
+#include "../../inc/emulator/host_counters.hpp"
+#include "../../inc/emulator/machine.hpp"
+
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+// counts the instructions a core executes
+class InstructionCounter : public Probe {
+public:
+    uint64_t count = 0;
+
+    bool instruction(const Computer::State&) override {
+        ++count;
+        return false;
+    }
+};
+
+// JSON-friendly names of the host counters
+constexpr const char* HOST_METRIC_NAMES[HostCounters::EVENT_COUNT] { "cycles", "instructions", "branch_misses", "cache_misses" };
+
+uint16_t read_checksum(Machine& machine) {
+    return machine.memory->read(GuestBench::CHECKSUM_ADDRESS).value
+        | machine.memory->read(GuestBench::CHECKSUM_ADDRESS + 1).value << 8;
+}
+
+}
+
+GuestBench::GuestBench(const std::string& suite) {
+    std::ifstream file(suite);
+    if (!file)
+        throw std::runtime_error("GuestBench: cannot open " + suite);
+    const std::filesystem::path directory = std::filesystem::path(suite).parent_path();
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream s(line);
+        std::string binary, checksum;
+        if (!(s >> binary) || binary.starts_with('#'))
+            continue;
+        if (!(s >> checksum))
+            throw std::runtime_error("GuestBench: bad line in " + suite + ": " + line);
+        _programs.push_back({
+            std::filesystem::path(binary).stem().string(),
+            (directory / binary).string(),
+            static_cast<uint16_t>(std::stoul(checksum, nullptr, 0)),
+        });
+    }
+}
+
+bool GuestBench::run(Bench& bench) {
+    HostCounters host_counters;
+    if (!host_counters.available())
+        std::cerr << "Host counters unavailable (" << host_counters.error() << "), leaving them out.\n";
+
+    bool passed = true;
+    for (const Program& program: _programs) {
+        const std::string name = "guest/" + program.name;
+        if (!bench.selected(name))
+            continue;
+
+        if (!std::ifstream(program.binary))
+            throw std::runtime_error("GuestBench: cannot open " + program.binary);
+        MemoryMap map;
+        map.read(program.binary);
+        Machine machine;
+        Computer core;
+        core.attach_memory(machine.memory);
+        core.debug_init();
+
+        // programs set up all the memory they use, so a run only needs a fresh image and reset
+        const auto run = [&] () {
+            machine.load(map);
+            core.reset();
+            core.step_sync(CYCLE_LIMIT);
+        };
+
+        // count the instructions once, outside the timed runs
+        InstructionCounter counter;
+        core.attach_probe(&counter);
+        run();
+        core.detach_probe(&counter);
+        const uint64_t cycles = core.get_state().cycle;
+        if (!core.halted()) {
+            std::cerr << std::format("{}: did not finish in {} cycles\n", program.name, CYCLE_LIMIT);
+            passed = false;
+            continue;
+        }
+
+        // the host counters cover every run, warmup included
+        uint64_t runs = 0;
+        const HostCounters::Sample begin = host_counters.read();
+        bench.run(name, "run", [&] (uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i)
+                run();
+            runs += n;
+        });
+        const HostCounters::Sample end = host_counters.read();
+        const Bench::Result& result = bench.results().back();
+        bench.metric("instructions", counter.count);
+        bench.metric("cpi", static_cast<double>(cycles) / counter.count);
+        bench.metric("mips", counter.count * 1e3 / result.median);
+        // host events per guest instruction
+        for (int event = 0; event < HostCounters::EVENT_COUNT; ++event) {
+            if (begin.counts[event] && end.counts[event])
+                bench.metric(std::format("host_{}", HOST_METRIC_NAMES[event]), static_cast<double>(*end.counts[event] - *begin.counts[event]) / (runs * counter.count));
+        }
+
+        const uint16_t checksum = read_checksum(machine);
+        if (checksum != program.checksum) {
+            std::cerr << std::format("{}: checksum {:04x}, expected {:04x}\n", program.name, checksum, program.checksum);
+            passed = false;
+        }
+    }
+    return passed;
+}
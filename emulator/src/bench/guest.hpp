@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../../../common/inc/bench.hpp"
+
+// Guest benchmark suite: programs in the emulator's own assembly (programs/bench), each run from
+// reset on one core until it returns to its reset code and halts. A program leaves a 16-bit checksum
+// of its work at CHECKSUM_ADDRESS, which must match the one listed in the suite file.
+class GuestBench {
+public:
+    static constexpr uint16_t CHECKSUM_ADDRESS = 0x0200; // little endian, in the zero page
+    static constexpr uint64_t CYCLE_LIMIT = 1000000000; // a program still running after this has failed
+
+    struct Program {
+        std::string name;
+        std::string binary;
+        uint16_t checksum;
+    };
+
+private:
+    std::vector<Program> _programs;
+
+public:
+    // read a suite file: "<program binary> <checksum>" per line, binaries relative to the file
+    explicit GuestBench(const std::string& suite);
+
+    // time every program and add its instructions, cycles per instruction and emulated MIPS
+    // to the results, returns false if a program failed to finish or its checksum is wrong
+    bool run(Bench& bench);
+};
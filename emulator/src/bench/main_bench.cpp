@@ -0,0 +1,73 @@
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "../../inc/utils/arg_parse.hpp"
+#include "../../../common/inc/bench.hpp"
+#include "bus.hpp"
+#include "farm.hpp"
+#include "guest.hpp"
+#include "pipeline.hpp"
+
+// Microbenchmark frontend (make bench): runs the benchmarks, printing a table to stderr as they
+// finish and the results as JSON to stdout or a file.
+
+int main(int argc, const char* argv[]) {
+    ArgParse args(argc, argv);
+
+    if (auto error = args.get_error()) {
+        std::cerr << "Error parsing arguments: " << *error << std::endl;
+        return EINVAL;
+    }
+
+    auto samples_str = args.take_option("--samples");
+    auto warmup_str = args.take_option("--warmup");
+    auto filter = args.take_option("--filter");
+    auto output_file = args.take_option("--output");
+    auto suite_file = args.take_option("--suite");
+
+    if (args.has_remaining()) {
+        std::cerr << "Usage: " << argv[0] << " [--samples n] [--warmup seconds] [--filter name] [--output json file] [--suite guest suite]" << std::endl;
+        return EINVAL;
+    }
+
+    Bench::Options options;
+    if (samples_str.has_value())
+        options.samples = std::stoul(*samples_str);
+    if (warmup_str.has_value())
+        options.warmup_seconds = std::stod(*warmup_str);
+    if (filter.has_value())
+        options.filter = *filter;
+    if (options.samples == 0) {
+        std::cerr << "Sample count must be nonzero." << std::endl;
+        return EINVAL;
+    }
+
+    // the guest suite replaces the microbenchmarks
+    Bench bench(options);
+    bool passed = true;
+    if (suite_file.has_value()) {
+        try {
+            passed = GuestBench(*suite_file).run(bench);
+        } catch (const std::runtime_error& e) {
+            std::cerr << e.what() << std::endl;
+            return EIO;
+        }
+    } else {
+        PipelineBench().run(bench);
+        BusBench().run(bench);
+        FarmBench().run(bench);
+    }
+
+    bench.write_table(std::cerr);
+
+    if (output_file.has_value()) {
+        std::ofstream file(*output_file);
+        bench.write_json(file);
+    } else {
+        bench.write_json(std::cout);
+    }
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,205 @@
+#include "pipeline.hpp"
+#include "../../inc/emulator/machine.hpp"
+#include "../../../common/inc/encoding.hpp"
+
+#include <array>
+#include <format>
+#include <random>
+#include <stdexcept>
+
+static constexpr uint16_t CODE_ADDRESS = 0x0300;
+static constexpr uint16_t DATA_ADDRESS = 0x2000;
+static constexpr size_t STREAM_SIZE = 256; // instructions per synthetic stream
+
+static constexpr const char* ALU_NAMES[] {
+    "add", "adc", "sub", "sbc", "cmp", "cmc", "and", "or", "xor", "shl", "shr", "asr", "mov", "movh",
+};
+
+static constexpr const char* FORMAT_NAMES[] { "a", "ia", "m", "c" };
+
+static uint16_t format_bits(int format) {
+    return format << *Encoding::FMT_SHIFT;
+}
+
+// 6-bit immediate fields
+static uint16_t immediate(int value) {
+    const uint16_t i = value & 0x3F;
+    return (i & *Encoding::IL_MASK) | (i << *Encoding::IH_SHIFT & *Encoding::IH_MASK);
+}
+
+PipelineBench::PipelineBench() :
+    _random(1)
+{
+    _core.attach_memory(_machine.memory);
+    _core.debug_init();
+}
+
+// Return true if the instruction decodes and executes (a scratch state is used and thrown away).
+bool PipelineBench::_valid(uint16_t instruction) {
+    const Computer::State saved = _core.state;
+    bool valid = true;
+    try {
+        _core.state.instruction = instruction;
+        _core.decode_stage();
+        _core.execute_stage();
+    } catch (const std::runtime_error&) {
+        valid = false;
+    }
+    _core.state = saved;
+    return valid;
+}
+
+uint16_t PipelineBench::_random_instruction(int format) {
+    for (;;) {
+        uint16_t instruction = format_bits(format) | (_random() & ~*Encoding::FMT_MASK);
+        switch (format) {
+        case *Encoding::FMT_A:
+        case *Encoding::FMT_IA:
+            // only write gb to gd, so the streams keep their base registers
+            instruction = (instruction & ~*Encoding::X_MASK) | (5 + _random() % 3) << *Encoding::X_SHIFT;
+            break;
+        case *Encoding::FMT_M:
+            // gb to gd from or to gf + offset
+            instruction = (instruction & ~(*Encoding::X_MASK | *Encoding::M_MASK))
+                | (5 + _random() % 3) << *Encoding::X_SHIFT
+                | *AddrModeM::GF << *Encoding::M_SHIFT;
+            break;
+        case *Encoding::FMT_C:
+            // conditional relative jump to the next instruction, taken or not
+            instruction = format_bits(format) | *AddrModeC::REL << *Encoding::M_SHIFT
+                | (_random() % 7) << *Encoding::C_SHIFT | (_random() & *Encoding::N_MASK) | immediate(0);
+            break;
+        }
+        if (_valid(instruction))
+            return instruction;
+    }
+}
+
+// Write a stream of instructions at CODE_ADDRESS that jumps back to its start through ge.
+void PipelineBench::_load_stream(const std::vector<uint16_t>& instructions) {
+    uint16_t address = CODE_ADDRESS;
+    for (const uint16_t instruction: instructions) {
+        _machine.memory->debug_write(address++, instruction >> 8);
+        _machine.memory->debug_write(address++, instruction);
+    }
+    const uint16_t jump = format_bits(*Encoding::FMT_C) | *AddrModeC::GE << *Encoding::M_SHIFT | *JumpCond::ALW << *Encoding::C_SHIFT;
+    _machine.memory->debug_write(address++, jump >> 8);
+    _machine.memory->debug_write(address++, jump);
+
+    _core.reset();
+    _core.state.pc = CODE_ADDRESS;
+    _core.state.registers[*Register::GE_L] = CODE_ADDRESS & 0xFF;
+    _core.state.registers[*Register::GE_H] = CODE_ADDRESS >> 8;
+    _core.state.registers[*Register::GF_L] = DATA_ADDRESS & 0xFF;
+    _core.state.registers[*Register::GF_H] = DATA_ADDRESS >> 8;
+}
+
+void PipelineBench::_stages(Bench& bench) {
+    std::vector<uint16_t> instructions;
+    for (size_t i = 0; i < STREAM_SIZE; ++i)
+        instructions.push_back(_random_instruction(_random() % 4));
+    _load_stream(instructions);
+
+    Computer::State& state = _core.state;
+    bench.run("fetch", "stage", [&] (uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) {
+            state.pc = CODE_ADDRESS + (i % STREAM_SIZE) * 2;
+            _core.fetch_stage<false>();
+            Bench::keep(state.instruction);
+        }
+    });
+
+    for (int format = 0; format < 4; ++format) {
+        std::array<uint16_t, STREAM_SIZE> words;
+        for (uint16_t& word: words)
+            word = _random_instruction(format);
+        bench.run(std::format("decode/{}", FORMAT_NAMES[format]), "stage", [&] (uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) {
+                state.instruction = words[i % STREAM_SIZE];
+                _core.decode_stage();
+                Bench::keep(state.alu_op1);
+            }
+        });
+    }
+
+    std::array<std::pair<uint16_t, uint8_t>, STREAM_SIZE> operands;
+    for (auto& [op1, op2]: operands) {
+        op1 = _random();
+        op2 = _random();
+    }
+    for (uint8_t op = 0; op <= *ALUOp::MOVH; ++op) {
+        bench.run(std::format("execute/{}", ALU_NAMES[op]), "stage", [&] (uint64_t n) {
+            state.take_jump = false;
+            state.save_ret = false;
+            state.alu_set_flags = true;
+            for (uint64_t i = 0; i < n; ++i) {
+                state.alu_op = op;
+                state.alu_op1 = operands[i % STREAM_SIZE].first;
+                state.alu_op2 = operands[i % STREAM_SIZE].second;
+                _core.execute_stage();
+                Bench::keep(state.result);
+            }
+        });
+    }
+
+    bench.run("memory/load", "stage", [&] (uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) {
+            state.mem_op = *MemOp::LOAD;
+            state.result = DATA_ADDRESS + (i & 0x0FFF);
+            _core.memory_stage<false>();
+            Bench::keep(state.result);
+        }
+    });
+    bench.run("memory/store", "stage", [&] (uint64_t n) {
+        state.mem_op = *MemOp::STORE;
+        for (uint64_t i = 0; i < n; ++i) {
+            state.result = DATA_ADDRESS + (i & 0x0FFF);
+            state.store_val = i;
+            _core.memory_stage<false>();
+        }
+    });
+    bench.run("memory/none", "stage", [&] (uint64_t n) {
+        state.mem_op = *MemOp::NONE;
+        for (uint64_t i = 0; i < n; ++i) {
+            _core.memory_stage<false>();
+            Bench::keep(state.result);
+        }
+    });
+}
+
+// Whole instructions (five _step() calls each) over synthetic streams with a given mix of formats.
+void PipelineBench::_steps(Bench& bench) {
+    struct Mix {
+        const char* name;
+        int weights[4]; // per format, out of 100
+    };
+    static constexpr Mix MIXES[] {
+        { "alu", { 50, 50, 0, 0 } },
+        { "memory", { 0, 0, 100, 0 } },
+        { "branch", { 25, 25, 0, 50 } },
+        { "mixed", { 30, 30, 25, 15 } },
+    };
+
+    for (const Mix& mix: MIXES) {
+        const std::string name = std::format("step/{}", mix.name);
+        if (!bench.selected(name))
+            continue;
+        std::vector<uint16_t> instructions;
+        for (size_t i = 0; i < STREAM_SIZE; ++i) {
+            int pick = _random() % 100, format = 0;
+            while (pick >= mix.weights[format])
+                pick -= mix.weights[format++];
+            instructions.push_back(_random_instruction(format));
+        }
+        _load_stream(instructions);
+        bench.run(name, "instruction", [&] (uint64_t n) {
+            for (uint64_t i = 0; i < n * 5; ++i)
+                _core._step<false>();
+        });
+    }
+}
+
+void PipelineBench::run(Bench& bench) {
+    _stages(bench);
+    _steps(bench);
+}
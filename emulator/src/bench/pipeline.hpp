@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "../../inc/emulator/computer.hpp"
+#include "../../inc/emulator/machine.hpp"
+#include "../../../common/inc/bench.hpp"
+
+// Microbenchmarks of the pipeline stages of one core, and of whole instructions over synthetic
+// instruction streams loaded into main memory.
+class PipelineBench {
+private:
+    Machine _machine;
+    Computer _core;
+    std::mt19937 _random;
+
+    bool _valid(uint16_t instruction);
+    uint16_t _random_instruction(int format);
+    void _load_stream(const std::vector<uint16_t>& instructions);
+    void _stages(Bench& bench);
+    void _steps(Bench& bench);
+
+public:
+    PipelineBench();
+
+    void run(Bench& bench);
+};
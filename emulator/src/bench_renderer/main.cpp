@@ -0,0 +1,139 @@
+#include <SFML/Graphics/RenderTexture.hpp>
+
+#include <cstdlib>
+#include <exception>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../../inc/emulator/screen.hpp"
+#include "../../inc/frontend/screen_renderer.hpp"
+#include "../../inc/utils/arg_parse.hpp"
+#include "../../../common/inc/bench.hpp"
+
+// Screen renderer benchmark (make bench-renderer): draws frames to an offscreen target while the
+// screen memory stays the same, changes completely or changes in part between frames, and reports
+// the CPU time per frame of each phase of ScreenRenderer::draw() and of the whole against the
+// frame budget. Prints a table to stderr and the results as JSON to stdout or a file.
+
+static constexpr unsigned int SCREEN_WIDTH = 80;
+static constexpr unsigned int SCREEN_HEIGHT = 50;
+static constexpr unsigned int DEFAULT_FRAMES = 300;
+static constexpr double PARTIAL_CHANGE = 0.05; // of the cells changed per frame in the partial scenario
+
+namespace {
+
+enum class Scenario {
+    STATIC,
+    FULL,
+    PARTIAL,
+};
+
+// write a random character and color to a cell
+void change_cell(Screen& screen, size_t cell, std::mt19937& random) {
+    screen.memory().write(cell * 2, random());
+    screen.memory().write(cell * 2 + 1, random());
+}
+
+void bench_scenario(Bench& bench, const std::string& name, Scenario scenario, unsigned int frames) {
+    Screen screen(SCREEN_WIDTH, SCREEN_HEIGHT);
+    ScreenRenderer renderer(&screen, 0, 0);
+    sf::RenderTexture target({ SCREEN_WIDTH * 8, SCREEN_HEIGHT * 8 });
+    std::mt19937 random(1);
+
+    const size_t cells = SCREEN_WIDTH * SCREEN_HEIGHT;
+    for (size_t cell = 0; cell < cells; ++cell)
+        change_cell(screen, cell, random);
+
+    std::vector<double> read, expand, upload, draw, total;
+    // the first frame is a warmup
+    for (unsigned int frame = 0; frame <= frames; ++frame) {
+        if (scenario == Scenario::FULL) {
+            for (size_t cell = 0; cell < cells; ++cell)
+                change_cell(screen, cell, random);
+        } else if (scenario == Scenario::PARTIAL) {
+            for (size_t i = 0; i < cells * PARTIAL_CHANGE; ++i)
+                change_cell(screen, random() % cells, random);
+        }
+
+        target.clear();
+        renderer.draw(target);
+        target.display();
+        if (frame == 0)
+            continue;
+
+        const ScreenRenderer::FrameTime& time = renderer.get_last_frame();
+        read.push_back(time.read * 1e9);
+        expand.push_back(time.expand * 1e9);
+        upload.push_back(time.upload * 1e9);
+        draw.push_back(time.draw * 1e9);
+        total.push_back(time.total() * 1e9);
+    }
+
+    const auto record = [&] (const std::string& phase, const std::vector<double>& samples) {
+        if (!bench.selected(name + "/" + phase))
+            return false;
+        bench.record(name + "/" + phase, "frame", 1, samples);
+        bench.metric("budget_pct", 100 * bench.results().back().median / (ScreenRenderer::FRAME_BUDGET * 1e9));
+        return true;
+    };
+    record("read", read);
+    record("expand", expand);
+    record("upload", upload);
+    record("draw", draw);
+    if (record("total", total))
+        bench.metric("over_budget", renderer.get_frames_over_budget());
+}
+
+}
+
+int main(int argc, const char* argv[]) {
+    ArgParse args(argc, argv);
+
+    if (auto error = args.get_error()) {
+        std::cerr << "Error parsing arguments: " << *error << std::endl;
+        return EINVAL;
+    }
+
+    auto frames_str = args.take_option("--frames");
+    auto filter = args.take_option("--filter");
+    auto output_file = args.take_option("--output");
+
+    if (args.has_remaining()) {
+        std::cerr << "Usage: " << argv[0] << " [--frames n] [--filter name] [--output json file]" << std::endl;
+        return EINVAL;
+    }
+
+    Bench::Options options;
+    const unsigned int frames = frames_str.has_value() ? std::stoul(*frames_str) : DEFAULT_FRAMES;
+    if (filter.has_value())
+        options.filter = *filter;
+    if (frames == 0) {
+        std::cerr << "Frame count must be nonzero." << std::endl;
+        return EINVAL;
+    }
+
+    Bench bench(options);
+    try {
+        bench_scenario(bench, "renderer/static", Scenario::STATIC, frames);
+        bench_scenario(bench, "renderer/full", Scenario::FULL, frames);
+        bench_scenario(bench, "renderer/partial", Scenario::PARTIAL, frames);
+    } catch (const std::exception& e) {
+        // no graphics context, e.g. without a display
+        std::cerr << e.what() << std::endl;
+        return EIO;
+    }
+
+    bench.write_table(std::cerr);
+
+    if (output_file.has_value()) {
+        std::ofstream file(*output_file);
+        bench.write_json(file);
+    } else {
+        bench.write_json(std::cout);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,83 @@
+#include "../../inc/emulator/breakpoints.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+Breakpoints::Breakpoints() :
+    _next_id(1)
+{
+    for (std::atomic_uint8_t& flags: _flags)
+        flags.store(0, std::memory_order_relaxed);
+}
+
+// recompute the flags of an address range from the entries
+void Breakpoints::_update(uint16_t first, uint16_t last) {
+    for (size_t address = first; address <= last; ++address) {
+        uint8_t kinds = 0;
+        for (const auto& [id, entry]: _entries) {
+            if (entry.first <= address && address <= entry.last)
+                kinds |= entry.kinds;
+        }
+        _flags[address].store(kinds, std::memory_order_relaxed);
+    }
+}
+
+void Breakpoints::_hit(const Hit& hit) {
+    std::lock_guard lock(_hits_mutex);
+    _hits.push_back(hit);
+}
+
+size_t Breakpoints::add(uint16_t first, uint16_t last, uint8_t kinds) {
+    if (first > last || kinds == 0)
+        throw std::invalid_argument("Breakpoints::add(): empty range or no kinds");
+    const size_t id = _next_id++;
+    _entries[id] = Entry { first, last, kinds };
+    for (size_t address = first; address <= last; ++address)
+        _flags[address].fetch_or(kinds, std::memory_order_relaxed);
+    return id;
+}
+
+bool Breakpoints::remove(size_t id) {
+    const auto it = _entries.find(id);
+    if (it == _entries.end())
+        return false;
+    const Entry entry = it->second;
+    _entries.erase(it);
+    _update(entry.first, entry.last);
+    return true;
+}
+
+void Breakpoints::clear() {
+    _entries.clear();
+    for (std::atomic_uint8_t& flags: _flags)
+        flags.store(0, std::memory_order_relaxed);
+}
+
+bool Breakpoints::empty() const {
+    return _entries.empty();
+}
+
+const std::map<size_t, Breakpoints::Entry>& Breakpoints::entries() const {
+    return _entries;
+}
+
+std::vector<Breakpoints::Hit> Breakpoints::take_hits() {
+    std::lock_guard lock(_hits_mutex);
+    return std::exchange(_hits, {});
+}
+
+bool Breakpoints::instruction(const Computer::State& state) {
+    if (!(_flags[state.pc].load(std::memory_order_relaxed) & BREAK)) [[likely]]
+        return false;
+    _hit({ BREAK, state.pc, state.pc, state.cycle });
+    return true;
+}
+
+bool Breakpoints::access(const Computer::State& state, uint16_t address, bool write) {
+    const Kind kind = write ? WRITE : READ;
+    if (!(_flags[address].load(std::memory_order_relaxed) & kind)) [[likely]]
+        return false;
+    // pc has moved past the instruction (memory instructions don't jump)
+    _hit({ kind, static_cast<uint16_t>(state.pc - 2), address, state.cycle });
+    return true;
+}
@@ -0,0 +1,173 @@
+#include "../../inc/emulator/call_profiler.hpp"
+#include "../../../common/inc/encoding.hpp"
+
+#include <algorithm>
+#include <format>
+#include <vector>
+
+CallProfiler::CallProfiler() {
+    clear();
+}
+
+void CallProfiler::clear() {
+    _functions.clear();
+    _stack.clear();
+    _cycle = 0;
+    _pc = 0;
+    _resyncs = 0;
+}
+
+const std::unordered_map<uint16_t, CallProfiler::Function>& CallProfiler::functions() const {
+    return _functions;
+}
+
+uint64_t CallProfiler::resyncs() const {
+    return _resyncs;
+}
+
+CallProfiler::Function& CallProfiler::_function(uint16_t entry) {
+    return _functions.try_emplace(entry, Function { 0, {} }).first->second;
+}
+
+void CallProfiler::_push(uint16_t entry, uint16_t call_site, uint16_t return_address, bool root, uint64_t cycle) {
+    if (!root) {
+        Function& caller = *_stack.back().function;
+        ++caller.callees[{ entry, call_site }].calls;
+    }
+    if (_stack.size() == MAX_DEPTH)
+        _stack.pop_front();
+    _stack.push_back({ &_function(entry), entry, call_site, return_address, root, cycle });
+}
+
+// Pop down to the frame returning to target.
+void CallProfiler::_return(uint16_t target, uint64_t cycle) {
+    auto it = std::find_if(_stack.rbegin(), _stack.rend(), [target] (const Frame& frame) {
+        return !frame.root && frame.return_address == target;
+    });
+    size_t count = it - _stack.rbegin() + 1;
+    if (it == _stack.rend()) {
+        ++_resyncs;
+        count = 1;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        const Frame frame = _stack.back();
+        _stack.pop_back();
+        if (frame.root)
+            break;
+        // the caller may have dropped off the bottom of a full stack
+        if (_stack.empty()) {
+            _push(target, target, 0, true, cycle);
+            return;
+        }
+        _stack.back().function->callees[{ frame.entry, frame.call_site }].inclusive += cycle - frame.cycle;
+    }
+    // returned from the root: carry on in a new one
+    if (_stack.empty())
+        _push(target, target, 0, true, cycle);
+}
+
+bool CallProfiler::instruction(const Computer::State& state) {
+    if (_stack.empty()) [[unlikely]] {
+        _push(state.pc, state.pc, 0, true, state.cycle);
+        _cycle = state.cycle;
+        _pc = state.pc;
+        return false;
+    }
+
+    _stack.back().function->exclusive += state.cycle - _cycle;
+    _cycle = state.cycle;
+
+    // state still describes the instruction that just finished
+    if (state.take_jump) {
+        const uint16_t mode = (state.instruction & *Encoding::M_MASK) >> *Encoding::M_SHIFT;
+        if (mode == *AddrModeC::RET)
+            _return(state.pc, state.cycle);
+        if (state.save_ret)
+            _push(state.pc, _pc, state.registers[*Register::RA_L] | state.registers[*Register::RA_H] << 8, false, state.cycle);
+    }
+    _pc = state.pc;
+    return false;
+}
+
+std::map<std::pair<const CallProfiler::Function*, std::pair<uint16_t, uint16_t>>, uint64_t> CallProfiler::_open(uint64_t cycle) const {
+    std::map<std::pair<const Function*, std::pair<uint16_t, uint16_t>>, uint64_t> open;
+    for (size_t i = 1; i < _stack.size(); ++i) {
+        const Frame& frame = _stack[i];
+        if (!frame.root)
+            open[{ _stack[i - 1].function, { frame.entry, frame.call_site } }] += cycle - frame.cycle;
+    }
+    return open;
+}
+
+void CallProfiler::report(std::ostream& out, const SymbolTable& symbols, uint64_t cycle, size_t top) const {
+    const auto open = _open(cycle);
+    const auto edge_inclusive = [&open] (const Function& function, const std::pair<uint16_t, uint16_t>& key, const Edge& edge) {
+        const auto it = open.find({ &function, key });
+        return edge.inclusive + (it != open.end() ? it->second : 0);
+    };
+
+    // a function's inclusive cycles are those of the calls to it, or, for a root, its own plus its calls'
+    std::unordered_map<uint16_t, uint64_t> inclusive;
+    std::unordered_map<uint16_t, uint64_t> calls;
+    uint64_t total = 0;
+    for (const auto& [entry, function]: _functions) {
+        total += function.exclusive;
+        for (const auto& [key, edge]: function.callees) {
+            inclusive[key.first] += edge_inclusive(function, key, edge);
+            calls[key.first] += edge.calls;
+        }
+    }
+    for (const auto& [entry, function]: _functions) {
+        if (calls[entry] != 0)
+            continue;
+        inclusive[entry] = function.exclusive;
+        for (const auto& [key, edge]: function.callees)
+            inclusive[entry] += edge_inclusive(function, key, edge);
+    }
+
+    std::vector<std::pair<uint64_t, uint16_t>> sorted;
+    for (const auto& [entry, function]: _functions)
+        sorted.emplace_back(function.exclusive, entry);
+    top = std::min(top, sorted.size());
+    std::partial_sort(sorted.begin(), sorted.begin() + top, sorted.end(), [] (const auto& a, const auto& b) {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    });
+
+    out << std::format("{} cycles, {} unmatched returns\n\n", total, _resyncs);
+    out << std::format("{:>14} {:>7} {:>14} {:>10}  {}\n", "exclusive", "%", "inclusive", "calls", "function");
+    for (size_t i = 0; i < top; ++i) {
+        const auto [exclusive, entry] = sorted[i];
+        out << std::format("{:>14} {:>6.2f}% {:>14} {:>10}  {}\n",
+            exclusive, total != 0 ? 100.0 * exclusive / total : 0.0, inclusive[entry], calls[entry], symbols.format(entry));
+    }
+}
+
+void CallProfiler::write_callgrind(std::ostream& out, const SymbolTable& symbols, uint64_t cycle) const {
+    const auto open = _open(cycle);
+    uint64_t total = 0;
+    for (const auto& [entry, function]: _functions)
+        total += function.exclusive;
+
+    out << "# callgrind format\n";
+    out << "version: 1\n";
+    out << "creator: emulator\n";
+    out << "positions: instr\n";
+    out << "events: Cycles\n";
+    out << std::format("summary: {}\n", total);
+
+    std::map<uint16_t, const Function*> sorted;
+    for (const auto& [entry, function]: _functions)
+        sorted[entry] = &function;
+    // exclusive cycles at the entry address, calls at their call sites
+    for (const auto& [entry, function]: sorted) {
+        out << std::format("\nfn=({}) {}\n", entry, symbols.format(entry));
+        out << std::format("0x{:04x} {}\n", entry, function->exclusive);
+        for (const auto& [key, edge]: function->callees) {
+            const auto it = open.find({ function, key });
+            out << std::format("cfn=({}) {}\n", key.first, symbols.format(key.first));
+            out << std::format("calls={} 0x{:04x}\n", edge.calls, key.first);
+            out << std::format("0x{:04x} {}\n", key.second, edge.inclusive + (it != open.end() ? it->second : 0));
+        }
+    }
+}
@@ -0,0 +1,50 @@
+#include "../../inc/emulator/call_timeline.hpp"
+#include "../../../common/inc/encoding.hpp"
+
+#include <algorithm>
+#include <format>
+#include <utility>
+
+CallTimeline::CallTimeline(EventTrace& trace, const SymbolTable& symbols, uint32_t core) :
+    _trace(trace),
+    _symbols(symbols),
+    _core(core),
+    _started(false)
+{
+    _trace.name_track(EventTrace::GUEST, _core, std::format("core {}", _core));
+}
+
+void CallTimeline::_end(const Frame& frame, uint64_t end) {
+    _trace.span(_symbols.format(frame.entry), "call", frame.begin, end, EventTrace::GUEST, _core);
+}
+
+void CallTimeline::finish() {
+    const uint64_t now = EventTrace::now();
+    for (; !_stack.empty(); _stack.pop_back())
+        _end(_stack.back(), now);
+}
+
+bool CallTimeline::instruction(const Computer::State& state) {
+    // state still describes the instruction that just finished, except before the first one
+    if (!std::exchange(_started, true) || !state.take_jump)
+        return false;
+
+    const uint64_t now = EventTrace::now();
+    const uint16_t mode = (state.instruction & *Encoding::M_MASK) >> *Encoding::M_SHIFT;
+    if (mode == *AddrModeC::RET && !_stack.empty()) {
+        auto it = std::find_if(_stack.rbegin(), _stack.rend(), [&state] (const Frame& frame) {
+            return frame.return_address == state.pc;
+        });
+        const size_t count = it == _stack.rend() ? 1 : it - _stack.rbegin() + 1;
+        for (size_t i = 0; i < count; ++i) {
+            _end(_stack.back(), now);
+            _stack.pop_back();
+        }
+    }
+    if (state.save_ret) {
+        if (_stack.size() == MAX_DEPTH)
+            _stack.pop_front();
+        _stack.push_back({ state.pc, static_cast<uint16_t>(state.registers[*Register::RA_L] | state.registers[*Register::RA_H] << 8), now });
+    }
+    return false;
+}
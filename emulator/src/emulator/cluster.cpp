@@ -0,0 +1,156 @@
+#include "../../inc/emulator/cluster.hpp"
+#include "../../inc/emulator/event_trace.hpp"
+#include "../../../common/inc/encoding.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <barrier>
+#include <exception>
+#include <format>
+#include <stdexcept>
+#include <thread>
+
+Cluster::Cluster(size_t cores, const MemoryDevicePointer& memory) {
+    if (cores == 0)
+        throw std::invalid_argument("Cluster: at least one core is required");
+    _cores.reserve(cores);
+    for (size_t i = 0; i < cores; ++i) {
+        _cores.emplace_back(std::make_unique<Computer>());
+        _cores.back()->attach_memory(memory);
+    }
+}
+
+size_t Cluster::size() const {
+    return _cores.size();
+}
+
+Computer& Cluster::core(size_t index) {
+    return *_cores[index];
+}
+
+const Computer& Cluster::core(size_t index) const {
+    return *_cores[index];
+}
+
+std::vector<Computer*> Cluster::cores() {
+    std::vector<Computer*> cores;
+    for (auto& core: _cores)
+        cores.push_back(core.get());
+    return cores;
+}
+
+void Cluster::reset() {
+    for (size_t i = 0; i < _cores.size(); ++i) {
+        _cores[i]->reset();
+        Computer::State state = _cores[i]->get_state();
+        state.registers[*Register::GD] = i;
+        _cores[i]->set_state(state);
+    }
+}
+
+void Cluster::debug_init() {
+    for (auto& core: _cores)
+        core->debug_init();
+}
+
+void Cluster::step_sync(uint64_t count, uint64_t quantum, Sync sync) {
+    if (_cores.size() == 1) {
+        _cores[0]->step_sync(count);
+        return;
+    }
+    if (quantum == 0)
+        throw std::invalid_argument("Cluster: quantum must be nonzero");
+
+    const size_t n = _cores.size();
+    std::atomic_bool failed = false;
+    std::atomic_bool stopped = false; // by a probe, or every core is halted until an event
+    std::exception_ptr error;
+    // cores that made no progress in the current round: halted until an event, which nothing in a
+    // synchronous run sends, so once they all are the run is over
+    std::atomic<size_t> stuck = 0;
+    auto end_round = [&] () noexcept {
+        if (stuck.exchange(0, std::memory_order_relaxed) == n)
+            stopped.store(true, std::memory_order_relaxed);
+    };
+    std::barrier barrier(n, end_round);
+    std::atomic<size_t> turn = 0;
+
+    auto worker = [&] (size_t index) {
+        Computer& core = *_cores[index];
+        if (EventTrace* trace = EventTrace::active())
+            trace->name_thread(std::format("core {}", index));
+        try {
+            // taking turns, stopped is only checked with the turn held: a core leaving without passing
+            // its turn would leave the cores after it waiting for it
+            auto running = [&] () {
+                return sync == Sync::DETERMINISTIC || !stopped.load(std::memory_order_relaxed);
+            };
+            for (uint64_t done = 0; done < count && !failed.load(std::memory_order_relaxed) && running();) {
+                const uint64_t cycles = std::min(quantum, count - done);
+                if (sync == Sync::DETERMINISTIC) {
+                    {
+                        EventTrace::Span span("turn wait", "cluster");
+                        for (size_t t = turn.load(std::memory_order_acquire); t != index; t = turn.load(std::memory_order_acquire)) {
+                            if (failed.load(std::memory_order_relaxed))
+                                return;
+                            turn.wait(t, std::memory_order_acquire);
+                        }
+                    }
+                    // checked with the turn held, so every run stops after the same turns
+                    if (stopped.load(std::memory_order_relaxed)) {
+                        turn.store((index + 1) % n, std::memory_order_release);
+                        turn.notify_all();
+                        break;
+                    }
+                    const uint64_t start = core.get_state().cycle;
+                    {
+                        EventTrace::Span span("quantum", "cluster");
+                        core.step_sync(cycles);
+                    }
+                    if (core.stopped_by_probe())
+                        stopped.store(true, std::memory_order_relaxed);
+                    // the turns so far since any core made progress, ending the run after a full round
+                    if (core.get_state().cycle != start)
+                        stuck.store(0, std::memory_order_relaxed);
+                    else if (stuck.fetch_add(1, std::memory_order_relaxed) + 1 == n)
+                        stopped.store(true, std::memory_order_relaxed);
+                    turn.store((index + 1) % n, std::memory_order_release);
+                    turn.notify_all();
+                } else {
+                    const uint64_t start = core.get_state().cycle;
+                    {
+                        EventTrace::Span span("quantum", "cluster");
+                        core.step_sync(cycles);
+                    }
+                    if (core.stopped_by_probe())
+                        stopped.store(true, std::memory_order_relaxed);
+                    if (core.get_state().cycle == start)
+                        stuck.fetch_add(1, std::memory_order_relaxed);
+                    EventTrace::Span span("barrier wait", "cluster");
+                    barrier.arrive_and_wait();
+                }
+                done += cycles;
+            }
+        } catch (...) {
+            if (!failed.exchange(true))
+                error = std::current_exception();
+            if (sync == Sync::DETERMINISTIC) {
+                turn.store((index + 1) % n, std::memory_order_release);
+                turn.notify_all();
+            }
+        }
+        // cores that finish early must not hold up the remaining cores at the barrier
+        if (sync == Sync::PARALLEL)
+            barrier.arrive_and_drop();
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(n);
+    for (size_t i = 0; i < n; ++i)
+        threads.emplace_back(worker, i);
+    for (auto& thread: threads)
+        thread.join();
+
+    if (error)
+        std::rethrow_exception(error);
+}
@@ -1,4 +1,7 @@
 #include "../../inc/emulator/computer.hpp"
+#include "../../inc/emulator/coverage.hpp"
+#include "../../inc/emulator/event_trace.hpp"
+#include "../../inc/emulator/profiler.hpp"
 #include "../../inc/emulator/spinlock.hpp"
 #include "../../../common/inc/encoding.hpp"
 
@@ -11,16 +14,49 @@
 #include <sstream>
 #include <stdexcept>
 #include <thread>
+#include <utility>
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// A core is the only writer of its statistics and page accesses: a relaxed load and store compiles
+// to a plain increment, and lets peek_statistics() or a monitor read them from another thread while
+// the core runs.
+static void count(uint64_t& counter, uint64_t n = 1) {
+    std::atomic_ref<uint64_t> ref(counter);
+    ref.store(ref.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
 
 // TODO: real hardware exceptions
 [[noreturn]] void Computer::throw_eil() {
     throw std::runtime_error(std::format("Illegal instruction: {:04x}", state.instruction));
 }
 
+void Computer::_check_fault(size_t address, const MemoryResult& result) {
+    switch (result.signal) {
+    case MemoryResult::Signal::OUT_OF_RANGE:
+        throw std::runtime_error(std::format("Memory fault: address {:04x} is not mapped", address));
+    case MemoryResult::Signal::CANNOT_READ:
+        throw std::runtime_error(std::format("Memory fault: address {:04x} cannot be read", address));
+    case MemoryResult::Signal::CANNOT_WRITE:
+        throw std::runtime_error(std::format("Memory fault: address {:04x} cannot be written", address));
+    default:
+        break;
+    }
+}
+
+template <bool CHECKED>
 void Computer::fetch_stage() {
-    const uint8_t high = _memory->read(state.pc).value;
-    const uint8_t low = _memory->read(state.pc + 1).value;
-    state.instruction = low | high << 8;
+    const MemoryResult high = _memory->read(state.pc);
+    const MemoryResult low = _memory->read(state.pc + 1);
+    if constexpr (CHECKED) {
+        if (_trap_faults) {
+            _check_fault(state.pc, high);
+            _check_fault(state.pc + 1, low);
+        }
+    }
+    state.instruction = low.value | high.value << 8;
     state.pc += 2;
 }
 
@@ -30,6 +66,7 @@ void Computer::decode_alu_op() {
     state.alu_op = (state.instruction & *Encoding::O_MASK) >> *Encoding::O_SHIFT;
     state.alu_write = ALU_WRITE.test(state.alu_op);
     state.alu_set_flags = ALU_SETF.test(state.alu_op);
+    _with_statistics([&] (Statistics& statistics) { count(statistics.alu_ops[state.alu_op]); });
 }
 
 void Computer::decode_x_register() {
@@ -142,7 +179,9 @@ void Computer::decode_stage() {
     state.alu_set_flags = true;
     state.save_ret = false;
     state.mem_op = *MemOp::NONE;
-    switch ((state.instruction & *Encoding::FMT_MASK) >> *Encoding::FMT_SHIFT) {
+    const unsigned int format = (state.instruction & *Encoding::FMT_MASK) >> *Encoding::FMT_SHIFT;
+    _with_statistics([&] (Statistics& statistics) { count(statistics.formats[format]); });
+    switch (format) {
     case *Encoding::FMT_A:
         decode_alu_op();
         decode_x_register();
@@ -165,6 +204,9 @@ void Computer::decode_stage() {
     case *Encoding::FMT_C:
         decode_c_addr_mode();
         decode_jump_condition();
+        _with_statistics([&] (Statistics& statistics) {
+            count(state.take_jump ? statistics.branches_taken : statistics.branches_not_taken);
+        });
         decode_immediate();
         state.alu_op2 <<= 1;
         state.alu_op = *ALUOp::ADD;
@@ -274,14 +316,41 @@ void Computer::execute_stage() {
         state.pc = res;
 }
 
+template <bool CHECKED>
 void Computer::memory_stage() {
     switch (state.mem_op) {
     case *MemOp::LOAD:
-        state.result = _memory->read(state.result).value;
+        _with_statistics([&] (Statistics& statistics) { count(statistics.loads); });
+        if (_page_accesses != nullptr) [[unlikely]]
+            count(_page_accesses->loads[state.result >> 8]);
+        if constexpr (CHECKED)
+            _call_access_probes(state.result, false);
+        if (_input_log != nullptr && _input_log->is_port(state.result)) [[unlikely]]
+            state.result = _read_input(state.result);
+        else {
+            const MemoryResult result = _memory->read(state.result);
+            if constexpr (CHECKED) {
+                if (_trap_faults)
+                    _check_fault(state.result, result);
+            }
+            state.result = result.value;
+        }
         break;
-    case *MemOp::STORE:
-        _memory->write(state.result, state.store_val);
+    case *MemOp::STORE: {
+        _with_statistics([&] (Statistics& statistics) { count(statistics.stores); });
+        if (_page_accesses != nullptr) [[unlikely]]
+            count(_page_accesses->stores[state.result >> 8]);
+        if constexpr (CHECKED)
+            _call_access_probes(state.result, true);
+        const MemoryResult result = _memory->write(state.result, state.store_val);
+        if (result.signal == MemoryResult::Signal::WAIT)
+            _halt(result.value);
+        else if constexpr (CHECKED) {
+            if (_trap_faults)
+                _check_fault(state.result, result);
+        }
         break;
+    }
     default:
         break;
     }
@@ -292,8 +361,125 @@ void Computer::writeback_stage() {
         state.registers[state.write_reg] = state.result;
 }
 
+// Futex wrappers used to park the run thread while the core is halted.
+static void futex_wait(std::atomic_uint32_t& word, uint32_t expected, const timespec* timeout) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT_PRIVATE, expected, timeout, nullptr, 0);
+}
+
+static void futex_wake(std::atomic_uint32_t& word) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+}
+
+void Computer::_halt(uint8_t timeout) {
+    state.halted = true;
+    state.wake_cycle = timeout == 0 ? 0 : state.cycle + timeout * WAIT_UNIT;
+}
+
+// The core stops at the end of the instruction that halted it.
+bool Computer::_idle() const {
+    return state.halted && state.stage == 0;
+}
+
+// Resume if an event arrived since the core last resumed. Events that arrive while the core is running
+// stay pending, so a halt right after one falls through immediately.
+// When replaying an input log, the events come from the log instead, and outside events are dropped.
+bool Computer::_take_event() {
+    if (_input_log != nullptr && _input_log->replaying()) {
+        _seen_events = _events.load(std::memory_order_acquire);
+        const InputLog::Entry* entry = _input_log->next();
+        if (entry == nullptr || entry->kind != InputLog::Kind::EVENT || entry->cycle > state.cycle)
+            return false;
+        if (entry->cycle < state.cycle)
+            _replay_diverged();
+        _input_log->pop();
+    } else {
+        const uint32_t events = _events.load(std::memory_order_acquire);
+        if (events == _seen_events)
+            return false;
+        _seen_events = events;
+        if (_input_log != nullptr)
+            _input_log->record({ state.cycle, InputLog::Kind::EVENT, 0, 0 });
+    }
+    state.halted = false;
+    return true;
+}
+
+// Cycle at which a halted core resumes without an outside event (0 = never): the wake cycle, or the
+// next event of a replayed input log.
+uint64_t Computer::_wake_cycle() const {
+    uint64_t cycle = state.wake_cycle;
+    if (_input_log != nullptr && _input_log->replaying()) {
+        const InputLog::Entry* entry = _input_log->next();
+        if (entry != nullptr && entry->kind == InputLog::Kind::EVENT && (cycle == 0 || entry->cycle < cycle))
+            cycle = std::max(entry->cycle, state.cycle);
+    }
+    return cycle;
+}
+
+// Read an input port, recording the value or taking it from the input log.
+uint8_t Computer::_read_input(uint16_t address) {
+    if (_input_log->replaying()) {
+        const InputLog::Entry* entry = _input_log->next();
+        if (entry == nullptr || entry->kind != InputLog::Kind::READ || entry->cycle != state.cycle || entry->address != address)
+            _replay_diverged();
+        const uint8_t value = entry->value;
+        _input_log->pop();
+        return value;
+    }
+    const uint8_t value = _memory->read(address).value;
+    _input_log->record({ state.cycle, InputLog::Kind::READ, address, value });
+    return value;
+}
+
+void Computer::_replay_diverged() {
+    throw std::runtime_error(std::format("Computer: replay diverged from the input log at cycle {:d}", state.cycle));
+}
+
+// Let up to count cycles pass without executing while halted, stopping at the wake cycle if there is one.
+uint64_t Computer::_skip_halted(uint64_t n) {
+    if (const uint64_t wake_cycle = _wake_cycle(); wake_cycle != 0)
+        n = std::min(n, wake_cycle - state.cycle);
+    state.cycle += n;
+    _with_statistics([&] (Statistics& statistics) { count(statistics.halted_cycles, n); });
+    if (state.cycle == state.wake_cycle)
+        state.halted = false;
+    _published_cycle.store(state.cycle, std::memory_order_relaxed);
+    return n;
+}
+
+// Block the run thread until wake(), stop() or the timeout.
+void Computer::_park(std::optional<std::chrono::nanoseconds> timeout) {
+    const uint32_t signal = _signal.load(std::memory_order_acquire);
+    if (!_run.load(std::memory_order_relaxed) || _events.load(std::memory_order_acquire) != _seen_events)
+        return;
+    if (timeout) {
+        const timespec ts {
+            static_cast<time_t>(timeout->count() / 1000000000),
+            static_cast<long>(timeout->count() % 1000000000)
+        };
+        futex_wait(_signal, signal, &ts);
+    } else {
+        futex_wait(_signal, signal, nullptr);
+    }
+}
+
 Computer::Computer() :
-    _run(false) 
+    _run(false),
+    _events(0),
+    _signal(0),
+    _seen_events(0),
+    _input_log(nullptr),
+    _profiler(nullptr),
+    _coverage(nullptr),
+    _page_accesses(nullptr),
+    _probe_stop_cycle(UINT64_MAX),
+    _probe_stopped(false),
+    _probe_access_hit(false),
+    _probes_muted(false),
+    _unmuted_probe(nullptr),
+    _trap_faults(false),
+    _published_cycle(0),
+    _statistics()
 {}
 
 Computer::~Computer() {
@@ -304,20 +490,39 @@ void Computer::attach_memory(const MemoryDevicePointer& device) {
     _memory = device;
 }
 
+void Computer::attach_input_log(InputLog* log) {
+    MSSpinLockGuard guard(_state_lock, MSSpinLockGuard::Type::MASTER);
+    _input_log = log;
+}
+
 void Computer::reset() {
     MSSpinLockGuard guard(_state_lock, MSSpinLockGuard::Type::SLAVE);
     state.stage = 0;
     state.cycle = 0;
     state.pc = 0x0000;
     state.registers[*Register::SR] = 0;
+    state.halted = false;
+    state.wake_cycle = 0;
+    _probe_stop_cycle = UINT64_MAX;
+    _probe_access_hit = false;
+    _published_cycle.store(0, std::memory_order_relaxed);
 }
 
+template <bool CHECKED>
 void Computer::_step() {
+    _with_statistics([&] (Statistics& statistics) { count(statistics.stage_cycles[state.stage]); });
     switch (state.stage++) {
-    case 0: fetch_stage(); break;
-    case 1: decode_stage(); break;
+    case 0: fetch_stage<CHECKED>(); break;
+    case 1:
+        decode_stage();
+        // state.pc already points past the instruction
+        if (_profiler != nullptr) [[unlikely]]
+            _profiler->executed(state.pc - 2, state.instruction);
+        if (_coverage != nullptr) [[unlikely]]
+            _coverage->executed(state.pc - 2, state.instruction, state.take_jump);
+        break;
     case 2: execute_stage(); break;
-    case 3: memory_stage(); break;
+    case 3: memory_stage<CHECKED>(); break;
     case 4: writeback_stage();
         state.stage = 0;
         break;
@@ -330,78 +535,283 @@ void Computer::_step() {
 
 static constexpr unsigned int MAX_FREERUN = 1000000;
 
+// Call the probes before the instruction at state.pc, returning true if one of them stops the core.
+// When the core resumes, the probes aren't called again for the instruction they stopped it at.
+bool Computer::_call_probes() {
+    if ((_probes_muted && _unmuted_probe == nullptr) || state.cycle == _probe_stop_cycle)
+        return false;
+    bool stop = std::exchange(_probe_access_hit, false);
+    for (Probe* probe: _probes) {
+        if (!_probes_muted || probe == _unmuted_probe)
+            stop |= probe->instruction(state);
+    }
+    if (stop) {
+        _probe_stop_cycle = state.cycle;
+        _probe_stopped = true;
+    }
+    return stop;
+}
+
+void Computer::_call_access_probes(uint16_t address, bool write) {
+    if (_probes_muted && _unmuted_probe == nullptr)
+        return;
+    for (Probe* probe: _probes) {
+        if (!_probes_muted || probe == _unmuted_probe)
+            _probe_access_hit |= probe->access(state, address, write);
+    }
+}
+
+// Execute up to count cycles, stopping early when the core goes idle or a probe stops it.
+// Returns the number of cycles executed.
+template <bool CHECKED>
+uint64_t Computer::_execute(uint64_t count) {
+    for (uint64_t c = 0; c != count; ++c) {
+        if (_idle())
+            return c;
+        if constexpr (CHECKED) {
+            if (state.stage == 0 && _call_probes())
+                return c;
+        }
+        _step<CHECKED>();
+    }
+    return count;
+}
+
+// the checked loop is only used while there are probes or memory faults are trapped, so neither costs
+// anything otherwise
+uint64_t Computer::_execute(uint64_t count) {
+    const uint64_t n = checked() ? _execute<true>(count) : _execute<false>(count);
+    _published_cycle.store(state.cycle, std::memory_order_relaxed);
+    return n;
+}
+
 void Computer::_run_worker(std::chrono::high_resolution_clock::duration period) {
     using namespace std::chrono_literals;
+    if (EventTrace* trace = EventTrace::active())
+        trace->name_thread("emulator");
     auto then = std::chrono::high_resolution_clock::now();
     while (_run.load(std::memory_order_relaxed)) {
-        auto next = then + period;
         MSSpinLockGuard guard(_state_lock, MSSpinLockGuard::Type::SLAVE);
-        unsigned int c = 0;
-        auto now = std::chrono::high_resolution_clock::now();
-        while (next <= now && c != MAX_FREERUN) {
-            then = next;
-            _step();
-            next += period;
-            ++c;
+        const uint64_t elapsed = (std::chrono::high_resolution_clock::now() - then) / period;
+        uint64_t due = std::min<uint64_t>(elapsed, MAX_FREERUN);
+        while (due != 0 && !_probe_stopped) {
+            if (_idle()) {
+                // the clock keeps running while halted: let the elapsed cycles pass without executing
+                const uint64_t n = _skip_halted(due);
+                then += n * period;
+                due -= n;
+                if (_take_event() || !state.halted)
+                    continue;
+                break;
+            }
+            EventTrace::Span span("run batch", "emulator");
+            const uint64_t n = _execute(due);
+            then += n * period;
+            due -= n;
         }
+
+        if (_probe_stopped) {
+            _run.store(false, std::memory_order_relaxed);
+            return;
+        }
+
+        std::optional<std::chrono::nanoseconds> timeout;
+        const bool idle = _idle();
+        if (idle && _wake_cycle() != 0)
+            timeout = (_wake_cycle() - state.cycle) * period;
         guard.release();
-        if (c < MAX_FREERUN)
+
+        if (idle)
+            _park(timeout);
+        else if (elapsed < MAX_FREERUN)
             std::this_thread::sleep_for(1ms);
     }
 }
 
-void Computer::_step_worker(uint64_t count) {
-    while (_run.load(std::memory_order_relaxed)) {
+void Computer::_step_worker(uint64_t count, bool park) {
+    while (_run.load(std::memory_order_relaxed) && count != 0) {
         MSSpinLockGuard guard(_state_lock, MSSpinLockGuard::Type::SLAVE);
-        for (unsigned int c = 0; c != MAX_FREERUN; ++c) {
-            if (count == 0)
+        if (_idle() && !_take_event()) {
+            if (_wake_cycle() != 0) {
+                count -= _skip_halted(count);
+                continue;
+            }
+            // halted until an event: a synchronous step has nothing left to do
+            if (!park)
                 return;
-            --count;
-            _step();
+            guard.release();
+            _park();
+            continue;
         }
+        count -= _execute(std::min<uint64_t>(count, MAX_FREERUN));
+        if (_probe_stopped)
+            return;
     }
 }
 
 void Computer::_freerun_worker() {
+    if (EventTrace* trace = EventTrace::active())
+        trace->name_thread("emulator");
     while (_run.load(std::memory_order_relaxed)) {
         MSSpinLockGuard guard(_state_lock, MSSpinLockGuard::Type::SLAVE);
-        // for (unsigned int c = 0; c != MAX_FREERUN; ++c)
-        //     _step();
-        unsigned int c = 0;
-        while (c != MAX_FREERUN) {
-            _step();
-            ++c;
+        if (_idle() && !_take_event()) {
+            // nothing to pace against: jump straight to the wake cycle
+            if (const uint64_t wake_cycle = _wake_cycle(); wake_cycle != 0) {
+                _skip_halted(wake_cycle - state.cycle);
+                continue;
+            }
+            guard.release();
+            _park();
+            continue;
+        }
+        {
+            EventTrace::Span span("run batch", "emulator");
+            _execute(MAX_FREERUN);
+        }
+        if (_probe_stopped) {
+            _run.store(false, std::memory_order_relaxed);
+            return;
         }
     }
 }
 
 void Computer::stop() {
     _run.store(false, std::memory_order_relaxed);
-    if (_run_thread.joinable())
+    if (_run_thread.joinable()) {
+        // the run thread may be parked
+        _signal.fetch_add(1, std::memory_order_release);
+        futex_wake(_signal);
         _run_thread.join();
+    }
+}
+
+void Computer::wake() {
+    _events.fetch_add(1, std::memory_order_release);
+    _signal.fetch_add(1, std::memory_order_release);
+    futex_wake(_signal);
+}
+
+bool Computer::halted() const {
+    MSSpinLockGuard guard(_state_lock, MSSpinLockGuard::Type::MASTER);
+    return state.halted;
 }
 
 void Computer::step(uint64_t count) {
     stop();
     _run.store(true, std::memory_order_relaxed);
-    _run_thread = std::thread(&Computer::_step_worker, this, count);
+    _probe_stopped = false;
+    _run_thread = std::thread(&Computer::_step_worker, this, count, true);
 }
 
 void Computer::step_sync(uint64_t count) {
     stop();
     _run.store(true, std::memory_order_relaxed);
-    _step_worker(count);
+    _probe_stopped = false;
+    _step_worker(count, false);
 }
 
 void Computer::run(double freq) {
     stop();
     _run.store(true, std::memory_order_relaxed);
+    _probe_stopped = false;
     if (std::isfinite(freq))
         _run_thread = std::thread(&Computer::_run_worker, this, std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(std::chrono::duration<double>(1.0 / freq)));
     else
         _run_thread = std::thread(&Computer::_freerun_worker, this);
 }
 
+Computer::State Computer::get_state() const {
+    MSSpinLockGuard guard(_state_lock, MSSpinLockGuard::Type::MASTER);
+    return state;
+}
+
+Computer::Statistics Computer::get_statistics() const {
+    Statistics statistics {};
+    _with_statistics([&] (const Statistics& counters) {
+        MSSpinLockGuard guard(_state_lock, MSSpinLockGuard::Type::MASTER);
+        statistics = counters;
+    });
+    return statistics;
+}
+
+Computer::Statistics Computer::peek_statistics() const {
+    static_assert(sizeof(Statistics) % sizeof(uint64_t) == 0);
+    constexpr size_t n = sizeof(Statistics) / sizeof(uint64_t);
+    Statistics statistics {};
+    _with_statistics([&] (const Statistics& counters) {
+        uint64_t* words = reinterpret_cast<uint64_t*>(const_cast<Statistics*>(&counters));
+        for (size_t i = 0; i < n; ++i)
+            reinterpret_cast<uint64_t*>(&statistics)[i] = std::atomic_ref<uint64_t>(words[i]).load(std::memory_order_relaxed);
+    });
+    return statistics;
+}
+
+void Computer::reset_statistics() {
+    _with_statistics([&] (Statistics& counters) {
+        MSSpinLockGuard guard(_state_lock, MSSpinLockGuard::Type::MASTER);
+        uint64_t* words = reinterpret_cast<uint64_t*>(&counters);
+        for (size_t i = 0; i < sizeof(Statistics) / sizeof(uint64_t); ++i)
+            std::atomic_ref<uint64_t>(words[i]).store(0, std::memory_order_relaxed);
+    });
+}
+
+uint64_t Computer::peek_cycle() const {
+    return _published_cycle.load(std::memory_order_relaxed);
+}
+
+void Computer::set_state(const State& state) {
+    MSSpinLockGuard guard(_state_lock, MSSpinLockGuard::Type::MASTER);
+    this->state = state;
+    _probe_stop_cycle = UINT64_MAX;
+    _probe_access_hit = false;
+    _published_cycle.store(state.cycle, std::memory_order_relaxed);
+}
+
+void Computer::attach_probe(Probe* probe) {
+    MSSpinLockGuard guard(_state_lock, MSSpinLockGuard::Type::MASTER);
+    _probes.push_back(probe);
+}
+
+void Computer::detach_probe(Probe* probe) {
+    MSSpinLockGuard guard(_state_lock, MSSpinLockGuard::Type::MASTER);
+    std::erase(_probes, probe);
+}
+
+void Computer::mute_probes(bool mute, Probe* except) {
+    MSSpinLockGuard guard(_state_lock, MSSpinLockGuard::Type::MASTER);
+    _probes_muted = mute;
+    _unmuted_probe = mute ? except : nullptr;
+}
+
+void Computer::attach_profiler(Profiler* profiler) {
+    MSSpinLockGuard guard(_state_lock, MSSpinLockGuard::Type::MASTER);
+    _profiler = profiler;
+}
+
+void Computer::attach_coverage(CoverageMap* coverage) {
+    MSSpinLockGuard guard(_state_lock, MSSpinLockGuard::Type::MASTER);
+    _coverage = coverage;
+}
+
+void Computer::attach_page_accesses(PageAccesses* accesses) {
+    MSSpinLockGuard guard(_state_lock, MSSpinLockGuard::Type::MASTER);
+    _page_accesses = accesses;
+}
+
+bool Computer::stopped_by_probe() const {
+    MSSpinLockGuard guard(_state_lock, MSSpinLockGuard::Type::MASTER);
+    return _probe_stopped;
+}
+
+void Computer::trap_memory_faults(bool trap) {
+    MSSpinLockGuard guard(_state_lock, MSSpinLockGuard::Type::MASTER);
+    _trap_faults = trap;
+}
+
+bool Computer::checked() const {
+    return !_probes.empty() || _trap_faults;
+}
+
 // Print a human-readable number (in hex, binary and unsigned and signed decimal).
 template <std::integral T>
 std::string hr_num(T x) {
@@ -450,6 +860,8 @@ void Computer::debug_init() {
     state.alu_write = false;
     state.alu_set_flags = false;
     state.take_jump = false;
+    state.halted = false;
+    state.wake_cycle = 0;
 }
 
 std::string Computer::debug_state() const {
@@ -460,6 +872,8 @@ std::string Computer::debug_state() const {
     MSSpinLockGuard guard(_state_lock, MSSpinLockGuard::Type::MASTER);
     const auto now = std::chrono::high_resolution_clock::now();
     const State copy = state;
+    Statistics statistics;
+    _with_statistics([&] (const Statistics& counters) { statistics = counters; });
     guard.release();
 
     const double dt = std::chrono::duration<double>(now - then).count();    
@@ -487,6 +901,7 @@ std::string Computer::debug_state() const {
     s << "sres:  " << std::format("{:s}", copy.alu_write) << '\n';
     s << "setf:  " << std::format("{:s}", copy.alu_set_flags) << '\n';
     s << "store: " << hr_num(copy.store_val) << '\n';
+    s << "halt:  " << (copy.halted ? (copy.wake_cycle != 0 ? std::format("until {:d}", copy.wake_cycle) : "until event") : "false") << '\n';
     s << '\n';
     s << "ra:    " << hr_num(bytes_to_num<uint16_t>(&copy.registers[*Register::RA_L])) << '\n';
     s << "sr:    " << hr_data(copy.registers[*Register::SR]) << '\n';
@@ -499,5 +914,33 @@ std::string Computer::debug_state() const {
     s << "gf:    " << hr_num(bytes_to_num<uint16_t>(&copy.registers[*Register::GF_L])) << '\n';
     s << "gg:    " << hr_num(bytes_to_num<uint16_t>(&copy.registers[*Register::GG_L])) << '\n';
     s << "gh:    " << hr_num(bytes_to_num<uint16_t>(&copy.registers[*Register::GH_L])) << '\n';
+
+    if constexpr (STATISTICS) {
+        static constexpr const char* ALU_OP_NAMES[] {
+            "add", "adc", "sub", "sbc", "cmp", "cmc", "and", "or", "xor", "shl", "shr", "asr", "mov", "movh",
+        };
+        s << '\n';
+        s << "fmt:   " << std::format("A {} IA {} M {} C {}", statistics.formats[0], statistics.formats[1], statistics.formats[2], statistics.formats[3]) << '\n';
+        s << "jump:  " << std::format("{} taken, {} not", statistics.branches_taken, statistics.branches_not_taken) << '\n';
+        s << "mem:   " << std::format("{} ld, {} st", statistics.loads, statistics.stores) << '\n';
+        s << "stage: " << std::format("{} {} {} {} {}", statistics.stage_cycles[0], statistics.stage_cycles[1],
+            statistics.stage_cycles[2], statistics.stage_cycles[3], statistics.stage_cycles[4]) << '\n';
+        s << "idle:  " << statistics.halted_cycles << '\n';
+        for (size_t op = 0; op < std::size(ALU_OP_NAMES); ++op) {
+            if (op % 4 == 0)
+                s << (op == 0 ? "alu:  " : "\n      ");
+            s << std::format(" {} {}", ALU_OP_NAMES[op], statistics.alu_ops[op]);
+        }
+        s << '\n';
+    }
     return s.str();
-}
\ No newline at end of file
+}
+
+// the unchecked stages are also called directly by the microbenchmarks
+template void Computer::fetch_stage<false>();
+template void Computer::memory_stage<false>();
+template void Computer::_step<false>();
+
+bool Probe::access(const Computer::State&, uint16_t, bool) {
+    return false;
+}
@@ -0,0 +1,385 @@
+#include "../../inc/emulator/condition.hpp"
+#include "../../../common/inc/encoding.hpp"
+
+#include <cctype>
+#include <format>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+
+struct Value {
+    Condition::Op op;
+    int64_t operand;
+};
+
+const std::unordered_map<std::string, Value> NAMES {
+    { "pc", { Condition::Op::PC, 0 } },
+    { "cycle", { Condition::Op::CYCLE, 0 } },
+    { "stage", { Condition::Op::STAGE, 0 } },
+    { "halted", { Condition::Op::HALTED, 0 } },
+    { "ra", { Condition::Op::REG16, *Register::RA_L } },
+    { "ra.l", { Condition::Op::REG8, *Register::RA_L } },
+    { "ra.h", { Condition::Op::REG8, *Register::RA_H } },
+    { "sr", { Condition::Op::REG8, *Register::SR } },
+    { "sp", { Condition::Op::REG8, *Register::SP } },
+    { "fp", { Condition::Op::REG8, *Register::FP } },
+    { "ga", { Condition::Op::REG8, *Register::GA } },
+    { "gb", { Condition::Op::REG8, *Register::GB } },
+    { "gc", { Condition::Op::REG8, *Register::GC } },
+    { "gd", { Condition::Op::REG8, *Register::GD } },
+    { "ge", { Condition::Op::REG16, *Register::GE_L } },
+    { "ge.l", { Condition::Op::REG8, *Register::GE_L } },
+    { "ge.h", { Condition::Op::REG8, *Register::GE_H } },
+    { "gf", { Condition::Op::REG16, *Register::GF_L } },
+    { "gf.l", { Condition::Op::REG8, *Register::GF_L } },
+    { "gf.h", { Condition::Op::REG8, *Register::GF_H } },
+    { "gg", { Condition::Op::REG16, *Register::GG_L } },
+    { "gg.l", { Condition::Op::REG8, *Register::GG_L } },
+    { "gg.h", { Condition::Op::REG8, *Register::GG_H } },
+    { "gh", { Condition::Op::REG16, *Register::GH_L } },
+    { "gh.l", { Condition::Op::REG8, *Register::GH_L } },
+    { "gh.h", { Condition::Op::REG8, *Register::GH_H } },
+    { "c", { Condition::Op::FLAG, *Status::C_SHIFT } },
+    { "v", { Condition::Op::FLAG, *Status::V_SHIFT } },
+    { "n", { Condition::Op::FLAG, *Status::N_SHIFT } },
+    { "z", { Condition::Op::FLAG, *Status::Z_SHIFT } },
+};
+
+// Recursive descent compiler, one function per precedence level.
+class Compiler {
+private:
+    const std::string& _text;
+    size_t _pos;
+    std::vector<Condition::Instruction>& _code;
+    size_t _depth;
+    size_t _max_depth;
+
+    [[noreturn]] void _error(const std::string& message) const {
+        throw std::invalid_argument(std::format("{} at column {} of \"{}\"", message, _pos + 1, _text));
+    }
+
+    void _skip_space() {
+        while (_pos < _text.size() && std::isspace((unsigned char)_text[_pos]))
+            ++_pos;
+    }
+
+    bool _accept(const char* token) {
+        _skip_space();
+        const std::string_view t(token);
+        if (_text.compare(_pos, t.size(), t) != 0)
+            return false;
+        // don't take the start of a longer operator ("<" of "<=", "&" of "&&", "." of "..")
+        if (t.size() == 1 && _pos + 1 < _text.size()) {
+            const char next = _text[_pos + 1];
+            if ((t == "<" || t == ">" || t == "!") && next == '=')
+                return false;
+            if ((t == "&" || t == "|") && next == t[0])
+                return false;
+        }
+        _pos += t.size();
+        return true;
+    }
+
+    void _expect(const char* token) {
+        if (!_accept(token))
+            _error(std::format("expected \"{}\"", token));
+    }
+
+    void _emit(Condition::Op op, int64_t operand = 0) {
+        using Op = Condition::Op;
+        switch (op) {
+        case Op::PUSH: case Op::PC: case Op::CYCLE: case Op::STAGE: case Op::HALTED:
+        case Op::REG8: case Op::REG16: case Op::FLAG:
+            if (++_depth > _max_depth)
+                _max_depth = _depth;
+            break;
+        case Op::IN:
+            _depth -= 2;
+            break;
+        case Op::ADD: case Op::SUB: case Op::AND: case Op::XOR: case Op::OR:
+        case Op::EQ: case Op::NE: case Op::LT: case Op::LE: case Op::GT: case Op::GE:
+            --_depth;
+            break;
+        case Op::JZ: case Op::JNZ: // pops when not jumping, the other operand replaces it
+            --_depth;
+            break;
+        default:
+            break;
+        }
+        _code.push_back({ op, operand });
+    }
+
+    void _primary() {
+        _skip_space();
+        if (_pos >= _text.size())
+            _error("unexpected end of expression");
+        const char c = _text[_pos];
+
+        if (_accept("(")) {
+            _or();
+            _expect(")");
+            return;
+        }
+        if (_accept("[")) {
+            _or();
+            _expect("]");
+            _emit(Condition::Op::LOAD);
+            return;
+        }
+        if (std::isdigit((unsigned char)c)) {
+            // hex only after 0x, so a leading zero isn't read as octal
+            const bool hex = _text.compare(_pos, 2, "0x") == 0 || _text.compare(_pos, 2, "0X") == 0;
+            size_t length;
+            int64_t value;
+            try {
+                value = std::stoll(_text.substr(_pos), &length, hex ? 16 : 10);
+            } catch (const std::exception&) {
+                _error("invalid number");
+            }
+            _pos += length;
+            _emit(Condition::Op::PUSH, value);
+            return;
+        }
+        if (std::isalpha((unsigned char)c)) {
+            size_t end = _pos;
+            while (end < _text.size() && std::isalnum((unsigned char)_text[end]))
+                ++end;
+            // byte of a wide register (but not the ".." of a range)
+            if (end + 1 < _text.size() && _text[end] == '.' && std::isalpha((unsigned char)_text[end + 1]))
+                end += 2;
+            const auto it = NAMES.find(_text.substr(_pos, end - _pos));
+            if (it == NAMES.end())
+                _error("unknown name");
+            _pos = end;
+            _emit(it->second.op, it->second.operand);
+            return;
+        }
+        _error("expected a value");
+    }
+
+    void _unary() {
+        if (_accept("!")) {
+            _unary();
+            _emit(Condition::Op::NOT);
+        } else if (_accept("~")) {
+            _unary();
+            _emit(Condition::Op::INV);
+        } else if (_accept("-")) {
+            _unary();
+            _emit(Condition::Op::NEG);
+        } else {
+            _primary();
+        }
+    }
+
+    void _additive() {
+        _unary();
+        for (;;) {
+            if (_accept("+")) {
+                _unary();
+                _emit(Condition::Op::ADD);
+            } else if (_accept("-")) {
+                _unary();
+                _emit(Condition::Op::SUB);
+            } else {
+                return;
+            }
+        }
+    }
+
+    void _relational() {
+        _additive();
+        for (;;) {
+            if (_accept("<=")) {
+                _additive();
+                _emit(Condition::Op::LE);
+            } else if (_accept(">=")) {
+                _additive();
+                _emit(Condition::Op::GE);
+            } else if (_accept("<")) {
+                _additive();
+                _emit(Condition::Op::LT);
+            } else if (_accept(">")) {
+                _additive();
+                _emit(Condition::Op::GT);
+            } else if (_accept("in")) {
+                _additive();
+                _expect("..");
+                _additive();
+                _emit(Condition::Op::IN);
+            } else {
+                return;
+            }
+        }
+    }
+
+    void _equality() {
+        _relational();
+        for (;;) {
+            if (_accept("==")) {
+                _relational();
+                _emit(Condition::Op::EQ);
+            } else if (_accept("!=")) {
+                _relational();
+                _emit(Condition::Op::NE);
+            } else {
+                return;
+            }
+        }
+    }
+
+    void _bit_and() {
+        _equality();
+        while (_accept("&")) {
+            _equality();
+            _emit(Condition::Op::AND);
+        }
+    }
+
+    void _bit_xor() {
+        _bit_and();
+        while (_accept("^")) {
+            _bit_and();
+            _emit(Condition::Op::XOR);
+        }
+    }
+
+    void _bit_or() {
+        _bit_xor();
+        while (_accept("|")) {
+            _bit_xor();
+            _emit(Condition::Op::OR);
+        }
+    }
+
+    // a && b: if a is false the result is a (0), else b normalized
+    void _and() {
+        _bit_or();
+        while (_accept("&&")) {
+            const size_t jump = _code.size();
+            _emit(Condition::Op::JZ);
+            _bit_or();
+            _emit(Condition::Op::BOOL);
+            _code[jump].operand = _code.size();
+        }
+    }
+
+    void _or() {
+        _and();
+        while (_accept("||")) {
+            const size_t jump = _code.size();
+            _emit(Condition::Op::JNZ);
+            _and();
+            _emit(Condition::Op::BOOL);
+            _code[jump].operand = _code.size();
+        }
+    }
+
+public:
+    Compiler(const std::string& text, std::vector<Condition::Instruction>& code) :
+        _text(text),
+        _pos(0),
+        _code(code),
+        _depth(0),
+        _max_depth(0)
+    {}
+
+    void compile() {
+        _or();
+        _skip_space();
+        if (_pos != _text.size())
+            _error("unexpected character");
+        if (_max_depth > Condition::MAX_DEPTH)
+            _error("expression too deeply nested");
+    }
+};
+
+}
+
+Condition::Condition(const std::string& expression) :
+    _expression(expression)
+{
+    Compiler(_expression, _code).compile();
+}
+
+int64_t Condition::evaluate(const Computer::State& state, const MemoryDevice& memory) const {
+    int64_t stack[MAX_DEPTH];
+    int64_t* top = stack - 1;
+    const Instruction* const code = _code.data();
+    const size_t size = _code.size();
+    for (size_t i = 0; i < size; ++i) {
+        const Instruction& instruction = code[i];
+        switch (instruction.op) {
+        case Op::PUSH: *++top = instruction.operand; break;
+        case Op::PC: *++top = state.pc; break;
+        case Op::CYCLE: *++top = state.cycle; break;
+        case Op::STAGE: *++top = state.stage; break;
+        case Op::HALTED: *++top = state.halted; break;
+        case Op::REG8: *++top = state.registers[instruction.operand]; break;
+        case Op::REG16: *++top = state.registers[instruction.operand] | state.registers[instruction.operand + 1] << 8; break;
+        case Op::FLAG: *++top = (state.registers[*Register::SR] >> instruction.operand) & 1; break;
+        case Op::LOAD: *top = memory.read(*top & 0xFFFF).value; break;
+        case Op::NOT: *top = !*top; break;
+        case Op::NEG: *top = -*top; break;
+        case Op::INV: *top = ~*top; break;
+        case Op::ADD: top[-1] += top[0]; --top; break;
+        case Op::SUB: top[-1] -= top[0]; --top; break;
+        case Op::AND: top[-1] &= top[0]; --top; break;
+        case Op::XOR: top[-1] ^= top[0]; --top; break;
+        case Op::OR: top[-1] |= top[0]; --top; break;
+        case Op::EQ: top[-1] = top[-1] == top[0]; --top; break;
+        case Op::NE: top[-1] = top[-1] != top[0]; --top; break;
+        case Op::LT: top[-1] = top[-1] < top[0]; --top; break;
+        case Op::LE: top[-1] = top[-1] <= top[0]; --top; break;
+        case Op::GT: top[-1] = top[-1] > top[0]; --top; break;
+        case Op::GE: top[-1] = top[-1] >= top[0]; --top; break;
+        case Op::IN: top[-2] = top[-1] <= top[-2] && top[-2] <= top[0]; top -= 2; break;
+        case Op::BOOL: *top = *top != 0; break;
+        case Op::JZ:
+            if (*top == 0)
+                i = instruction.operand - 1;
+            else
+                --top;
+            break;
+        case Op::JNZ:
+            if (*top != 0) {
+                *top = 1;
+                i = instruction.operand - 1;
+            } else {
+                --top;
+            }
+            break;
+        }
+    }
+    return *top;
+}
+
+const std::string& Condition::expression() const {
+    return _expression;
+}
+
+const std::vector<Condition::Instruction>& Condition::code() const {
+    return _code;
+}
+
+StopCondition::StopCondition(const Condition& condition, const MemoryDevicePointer& memory) :
+    _condition(condition),
+    _memory(memory),
+    _met(false)
+{}
+
+const Condition& StopCondition::condition() const {
+    return _condition;
+}
+
+bool StopCondition::met() const {
+    return _met.load(std::memory_order_relaxed);
+}
+
+bool StopCondition::instruction(const Computer::State& state) {
+    if (_met.load(std::memory_order_relaxed) || _condition.evaluate(state, *_memory) == 0)
+        return false;
+    _met.store(true, std::memory_order_relaxed);
+    return true;
+}
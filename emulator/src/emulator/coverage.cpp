@@ -0,0 +1,128 @@
+#include "../../inc/emulator/coverage.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <format>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+static constexpr char MAGIC[4] = { '8', 'B', 'C', 'V' };
+
+CoverageMap::CoverageMap() {
+    clear();
+}
+
+void CoverageMap::clear() {
+    _cells.fill(0);
+}
+
+void CoverageMap::merge(const CoverageMap& other) {
+    for (size_t i = 0; i < WORDS; ++i)
+        _cells[i] |= other._cells[i];
+}
+
+uint8_t CoverageMap::cell(uint16_t pc) const {
+    return (_cells[pc * CELL_BITS / 64] >> (pc * CELL_BITS % 64)) & 0x0F;
+}
+
+void CoverageMap::write(const std::string& filename) const {
+    std::ofstream file(filename, std::ios::binary);
+    if (!file)
+        throw std::runtime_error("CoverageMap: cannot open " + filename);
+    file.write(MAGIC, sizeof(MAGIC));
+    for (const uint64_t word: _cells) {
+        for (size_t i = 0; i < 8; ++i)
+            file.put(static_cast<char>(word >> (i * 8)));
+    }
+    if (!file)
+        throw std::runtime_error("CoverageMap: cannot write " + filename);
+}
+
+void CoverageMap::read(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file)
+        throw std::runtime_error("CoverageMap: cannot open " + filename);
+    char magic[sizeof(MAGIC)];
+    if (!file.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), MAGIC))
+        throw std::runtime_error("CoverageMap: " + filename + " is not a coverage map");
+    uint8_t bytes[WORDS * 8];
+    if (!file.read(reinterpret_cast<char*>(bytes), sizeof(bytes)))
+        throw std::runtime_error("CoverageMap: truncated file");
+    for (size_t i = 0; i < WORDS; ++i)
+        _cells[i] |= bytes_to_num<uint64_t>(bytes + i * 8);
+}
+
+void CoverageMap::report(std::ostream& out, const MemoryMap& program, const SymbolTable& symbols) const {
+    // instruction words of the program by address
+    std::map<uint16_t, uint16_t> instructions;
+    std::vector<std::pair<size_t, size_t>> sections;
+    for (const auto& [address, data]: program) {
+        if (data.empty())
+            continue;
+        sections.emplace_back(address, address + data.size());
+        for (size_t a = (address + 1) & ~size_t(1); a + 1 < address + data.size() && a <= 0xFFFF; a += 2)
+            instructions[a] = data[a - address] << 8 | data[a + 1 - address];
+    }
+    std::sort(sections.begin(), sections.end());
+
+    // labelled ranges, or the sections
+    std::vector<std::tuple<size_t, size_t, std::string>> ranges;
+    if (!symbols.empty()) {
+        // the first label of every address, up to the next address with a label
+        for (auto it = symbols.begin(); it != symbols.end(); ) {
+            auto next = std::next(it);
+            while (next != symbols.end() && next->first == it->first)
+                ++next;
+            ranges.emplace_back(it->first, next != symbols.end() ? next->first : 0x10000, it->second);
+            it = next;
+        }
+    } else {
+        for (const auto& [begin, end]: sections)
+            ranges.emplace_back(begin, end, std::format("{:04x}..{:04x}", begin, end - 1));
+    }
+
+    const auto line = [&out] (size_t executed, size_t count, size_t outcomes, size_t branches, const std::string& name) {
+        out << std::format("{:>7.2f}% {:>6}/{:<6} ", 100.0 * executed / count, executed, count);
+        if (branches != 0)
+            out << std::format("{:>7.2f}% {:>5}/{:<5}", 100.0 * outcomes / branches, outcomes, branches);
+        else
+            out << std::format("{:>8} {:>11}", "-", "");
+        out << "  " << name << '\n';
+    };
+
+    size_t total_instructions = 0, total_executed = 0, total_outcomes = 0, total_branches = 0;
+    out << std::format("{:>8} {:>13} {:>8} {:>11}  {}\n", "executed", "", "branches", "", "range");
+    for (const auto& [begin, end, name]: ranges) {
+        size_t count = 0, executed = 0, outcomes = 0, branches = 0;
+        for (auto it = instructions.lower_bound(begin); it != instructions.end() && it->first < end; ++it) {
+            const uint8_t bits = cell(it->first);
+            ++count;
+            executed += bits & EXECUTED;
+            if (is_conditional(it->second)) {
+                branches += 2;
+                outcomes += std::popcount<uint8_t>(bits & (TAKEN | NOT_TAKEN));
+            }
+        }
+        if (count == 0)
+            continue;
+        line(executed, count, outcomes, branches, name);
+        total_instructions += count;
+        total_executed += executed;
+        total_outcomes += outcomes;
+        total_branches += branches;
+    }
+    if (total_instructions != 0)
+        line(total_executed, total_instructions, total_outcomes, total_branches, "total");
+
+    // code that ran from memory the program didn't load (e.g. copied there at run time)
+    size_t outside = 0;
+    for (size_t pc = 0; pc < 0x10000; pc += 2) {
+        if ((cell(pc) & EXECUTED) && !instructions.contains(pc))
+            ++outside;
+    }
+    if (outside != 0)
+        out << std::format("{} executed instructions outside the program\n", outside);
+}
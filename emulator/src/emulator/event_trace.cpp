@@ -0,0 +1,109 @@
+#include "../../inc/emulator/event_trace.hpp"
+
+#include <chrono>
+#include <format>
+#include <fstream>
+#include <stdexcept>
+
+std::atomic<EventTrace*> EventTrace::_active = nullptr;
+
+static std::string json_escape(const std::string& str) {
+    std::string escaped;
+    for (const char c: str) {
+        if (c == '"' || c == '\\')
+            escaped += '\\';
+        if (static_cast<unsigned char>(c) >= 0x20)
+            escaped += c;
+    }
+    return escaped;
+}
+
+EventTrace::Span::Span(const char* name, const char* category) :
+    _trace(EventTrace::active()),
+    _name(name),
+    _category(category),
+    _begin(_trace != nullptr ? EventTrace::now() : 0)
+{}
+
+EventTrace::Span::~Span() {
+    if (_trace != nullptr)
+        _trace->span(_name, _category, _begin, EventTrace::now(), HOST, EventTrace::thread_track());
+}
+
+EventTrace::EventTrace() :
+    _counts {},
+    _dropped {}
+{}
+
+EventTrace::~EventTrace() {
+    stop();
+}
+
+uint64_t EventTrace::now() {
+    static const auto origin = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count();
+}
+
+uint32_t EventTrace::thread_track() {
+    static std::atomic_uint32_t next = 1;
+    thread_local const uint32_t track = next.fetch_add(1, std::memory_order_relaxed);
+    return track;
+}
+
+void EventTrace::start() {
+    EventTrace* expected = nullptr;
+    if (!_active.compare_exchange_strong(expected, this))
+        throw std::logic_error("EventTrace: another trace is already started");
+}
+
+void EventTrace::stop() {
+    EventTrace* expected = this;
+    _active.compare_exchange_strong(expected, nullptr);
+}
+
+void EventTrace::span(const std::string& name, const char* category, uint64_t begin, uint64_t end, uint32_t process, uint32_t track) {
+    std::lock_guard lock(_mutex);
+    if (_counts[process - 1] == MAX_EVENTS) {
+        ++_dropped[process - 1];
+        return;
+    }
+    ++_counts[process - 1];
+    _events.push_back({ name, category, begin, end, process, track });
+}
+
+void EventTrace::name_thread(const std::string& name) {
+    name_track(HOST, thread_track(), name);
+}
+
+void EventTrace::name_track(uint32_t process, uint32_t track, const std::string& name) {
+    std::lock_guard lock(_mutex);
+    _track_names[static_cast<uint64_t>(process) << 32 | track] = name;
+}
+
+uint64_t EventTrace::dropped(Process process) const {
+    std::lock_guard lock(_mutex);
+    return _dropped[process - 1];
+}
+
+void EventTrace::write(const std::string& filename) const {
+    std::lock_guard lock(_mutex);
+    std::ofstream file(filename);
+    if (!file)
+        throw std::runtime_error("EventTrace: cannot create " + filename);
+
+    file << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n";
+    file << std::format("{{\"ph\": \"M\", \"name\": \"process_name\", \"pid\": {}, \"args\": {{\"name\": \"host\"}}}},\n", static_cast<uint32_t>(HOST));
+    file << std::format("{{\"ph\": \"M\", \"name\": \"process_name\", \"pid\": {}, \"args\": {{\"name\": \"guest\"}}}}", static_cast<uint32_t>(GUEST));
+    for (const auto& [key, name]: _track_names) {
+        file << std::format(",\n{{\"ph\": \"M\", \"name\": \"thread_name\", \"pid\": {}, \"tid\": {}, \"args\": {{\"name\": \"{}\"}}}}",
+            key >> 32, key & 0xFFFFFFFF, json_escape(name));
+    }
+    // timestamps and durations are in microseconds
+    for (const Event& event: _events) {
+        file << std::format(",\n{{\"ph\": \"X\", \"name\": \"{}\", \"cat\": \"{}\", \"ts\": {:.3f}, \"dur\": {:.3f}, \"pid\": {}, \"tid\": {}}}",
+            json_escape(event.name), event.category, event.begin / 1e3, (event.end - event.begin) / 1e3, event.process, event.track);
+    }
+    file << "\n]}\n";
+    if (!file)
+        throw std::runtime_error("EventTrace: cannot write " + filename);
+}
@@ -0,0 +1,137 @@
+#include "../../inc/emulator/farm.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+
+Farm::Task::Task(Job&& job) :
+    job(std::move(job)),
+    remaining(this->job.cycles)
+{}
+
+Farm::Farm(size_t workers, uint64_t slice) :
+    _slice(slice),
+    _exit(false),
+    _queued(0),
+    _next_queue(0)
+{
+    if (workers == 0)
+        workers = 1;
+    if (slice == 0)
+        throw std::invalid_argument("Farm: slice must be nonzero");
+
+    _queues.reserve(workers);
+    for (size_t i = 0; i < workers; ++i)
+        _queues.emplace_back(std::make_unique<Queue>());
+    _workers.reserve(workers);
+    for (size_t i = 0; i < workers; ++i)
+        _workers.emplace_back(&Farm::_worker, this, i);
+}
+
+Farm::~Farm() {
+    {
+        std::lock_guard lock(_idle_mutex);
+        _exit.store(true, std::memory_order_relaxed);
+    }
+    _idle.notify_all();
+    for (auto& worker: _workers)
+        worker.join();
+}
+
+size_t Farm::size() const {
+    return _workers.size();
+}
+
+std::future<Farm::Result> Farm::submit(Job job) {
+    auto task = std::make_unique<Task>(std::move(job));
+    std::future<Result> future = task->promise.get_future();
+    _push(_next_queue.fetch_add(1, std::memory_order_relaxed) % _queues.size(), std::move(task));
+    return future;
+}
+
+void Farm::_push(size_t index, std::unique_ptr<Task>&& task) {
+    {
+        std::lock_guard lock(_queues[index]->mutex);
+        _queues[index]->tasks.emplace_back(std::move(task));
+    }
+    {
+        std::lock_guard lock(_idle_mutex);
+        _queued.fetch_add(1, std::memory_order_relaxed);
+    }
+    _idle.notify_one();
+}
+
+// Take the oldest task from our own queue, or steal the newest task from another worker.
+std::unique_ptr<Farm::Task> Farm::_take(size_t index) {
+    std::unique_ptr<Task> task;
+    for (size_t i = 0; i < _queues.size() && !task; ++i) {
+        Queue& queue = *_queues[(index + i) % _queues.size()];
+        std::lock_guard lock(queue.mutex);
+        if (queue.tasks.empty())
+            continue;
+        if (i == 0) {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        } else {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+    }
+    if (task)
+        _queued.fetch_sub(1, std::memory_order_relaxed);
+    return task;
+}
+
+// Run one time slice of a task; returns true once the task is finished.
+bool Farm::_run_slice(Task& task) {
+    if (!task.computer) {
+        task.machine = std::make_unique<Machine>();
+        task.computer = std::make_unique<Computer>();
+        task.computer->attach_memory(task.machine->memory);
+        task.computer->debug_init();
+        task.machine->load(task.job.image);
+        for (const Patch& patch: task.job.patches)
+            task.machine->memory->debug_write<Endian::LITTLE>(patch.address, patch.data);
+        task.computer->reset();
+    }
+
+    const uint64_t cycles = std::min(_slice, task.remaining);
+    task.computer->step_sync(cycles);
+    task.remaining -= cycles;
+    if (task.remaining != 0)
+        return false;
+
+    Result result;
+    result.state = task.computer->get_state();
+    const Screen& screen = task.machine->screen;
+    result.screen.resize(screen.width * screen.height * 2);
+    for (size_t i = 0; i < result.screen.size(); ++i)
+        result.screen[i] = screen.memory().read(i).value;
+    task.promise.set_value(std::move(result));
+    return true;
+}
+
+void Farm::_worker(size_t index) {
+    while (!_exit.load(std::memory_order_relaxed)) {
+        std::unique_ptr<Task> task = _take(index);
+        if (!task) {
+            std::unique_lock lock(_idle_mutex);
+            _idle.wait(lock, [&] () {
+                return _exit.load(std::memory_order_relaxed) || _queued.load(std::memory_order_relaxed) != 0;
+            });
+            continue;
+        }
+
+        bool done;
+        try {
+            done = _run_slice(*task);
+        } catch (...) {
+            task->promise.set_exception(std::current_exception());
+            done = true;
+        }
+
+        // unfinished tasks go to the back of our own queue, behind any shorter jobs waiting there
+        if (!done)
+            _push(index, std::move(task));
+    }
+}
@@ -0,0 +1,182 @@
+#include "../../inc/emulator/fuzzer.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+
+// AFL-style hit count classes: 1, 2, 3, 4-7, 8-15, 16-31, 32-127, 128+
+static uint8_t hit_class(uint8_t hits) {
+    if (hits <= 3)
+        return 1 << (hits - 1);
+    if (hits < 8)
+        return 1 << 3;
+    if (hits < 16)
+        return 1 << 4;
+    if (hits < 32)
+        return 1 << 5;
+    if (hits < 128)
+        return 1 << 6;
+    return 1 << 7;
+}
+
+bool Fuzzer::Coverage::instruction(const Computer::State& state) {
+    const uint16_t edge = state.pc ^ previous;
+    previous = state.pc >> 1;
+    if (hits[edge] == 0)
+        touched.push_back(edge);
+    if (hits[edge] != 0xFF)
+        ++hits[edge];
+    return false;
+}
+
+Fuzzer::Fuzzer(Machine& machine, Computer& core, const Config& config):
+    _machine(machine),
+    _core(core),
+    _config(config),
+    _random(config.seed),
+    _stats {}
+{
+    std::memset(_coverage.hits, 0, sizeof(_coverage.hits));
+    std::memset(_seen, 0, sizeof(_seen));
+}
+
+Fuzzer::~Fuzzer() {
+    _core.detach_probe(&_coverage);
+    _core.trap_memory_faults(false);
+}
+
+void Fuzzer::prepare() {
+    class StopAt: public Probe {
+    public:
+        uint16_t pc;
+        bool reached = false;
+
+        bool instruction(const Computer::State& state) override {
+            reached = state.pc == pc;
+            return reached;
+        }
+    } stop_at;
+    stop_at.pc = _config.start;
+
+    _core.attach_probe(&stop_at);
+    _core.step_sync(_config.start_budget);
+    _core.detach_probe(&stop_at);
+    if (!stop_at.reached)
+        throw std::runtime_error(std::format("Fuzzer: pc {:04x} not reached in {} cycles", _config.start, _config.start_budget));
+
+    // make sure the input lands in memory a snapshot covers
+    for (size_t i = 0; i < _config.input_size; ++i) {
+        const size_t address = _config.input_address + i;
+        const MemoryResult old = _machine.memory->read(address);
+        if (old.signal != MemoryResult::Signal::SUCCESS || _machine.memory->write(address, old.value).signal != MemoryResult::Signal::SUCCESS)
+            throw std::runtime_error(std::format("Fuzzer: input address {:04x} is not writable memory", address));
+    }
+
+    _start = _machine.snapshot({ &_core });
+    _core.attach_probe(&_coverage);
+    _core.trap_memory_faults();
+}
+
+// Fold the run's hit counts into the seen classes, returning true if the run reached something new.
+bool Fuzzer::_collect() {
+    bool found = false;
+    for (uint16_t edge: _coverage.touched) {
+        const uint8_t c = hit_class(_coverage.hits[edge]);
+        if (_seen[edge] == 0)
+            ++_stats.edges;
+        if ((_seen[edge] & c) == 0) {
+            _seen[edge] |= c;
+            found = true;
+        }
+        _coverage.hits[edge] = 0;
+    }
+    _coverage.touched.clear();
+    return found;
+}
+
+std::optional<Fuzzer::Crash> Fuzzer::run(const std::vector<uint8_t>& input) {
+    if (!_start)
+        throw std::logic_error("Fuzzer::run(): prepare() wasn't called");
+
+    _machine.restore(_start, { &_core });
+    for (size_t i = 0; i < _config.input_size; ++i)
+        _machine.memory->write(_config.input_address + i, i < input.size() ? input[i] : 0);
+    _coverage.previous = _config.start >> 1;
+
+    ++_stats.runs;
+    std::optional<Crash> crash;
+    try {
+        _core.step_sync(_config.budget);
+    } catch (const std::runtime_error& e) {
+        ++_stats.crashes;
+        crash = Crash { input, e.what(), _core.get_state() };
+        crash->input.resize(_config.input_size);
+        _crashes.try_emplace({ crash->state.pc, crash->what }, *crash);
+    }
+
+    if (_collect()) {
+        _corpus.push_back(input);
+        _corpus.back().resize(_config.input_size);
+    }
+    return crash;
+}
+
+std::vector<uint8_t> Fuzzer::_mutate() {
+    static constexpr uint8_t INTERESTING[] { 0x00, 0x01, 0x02, 0x0A, 0x10, 0x20, 0x40, 0x7F, 0x80, 0x81, 0xFE, 0xFF };
+
+    std::vector<uint8_t> input = _corpus.empty()
+        ? std::vector<uint8_t>(_config.input_size, 0)
+        : _corpus[_random() % _corpus.size()];
+    if (input.empty())
+        return input;
+
+    const size_t size = input.size();
+    const int count = 1 << (_random() % 4);
+    for (int n = 0; n < count; ++n) {
+        const size_t at = _random() % size;
+        switch (_random() % 6) {
+        case 0: // flip a bit
+            input[at] ^= 1 << (_random() % 8);
+            break;
+        case 1: // random byte
+            input[at] = _random();
+            break;
+        case 2: // small add or subtract
+            input[at] += (int)(_random() % 35) - 17;
+            break;
+        case 3: // interesting value
+            input[at] = INTERESTING[_random() % std::size(INTERESTING)];
+            break;
+        case 4: { // copy a block within the input
+            const size_t from = _random() % size;
+            const size_t length = _random() % (size - std::max(at, from)) + 1;
+            std::memmove(&input[at], &input[from], length);
+            break;
+        }
+        case 5: // splice in the tail of another corpus input
+            if (!_corpus.empty()) {
+                const std::vector<uint8_t>& other = _corpus[_random() % _corpus.size()];
+                std::copy(other.begin() + at, other.end(), input.begin() + at);
+            }
+            break;
+        }
+    }
+    return input;
+}
+
+std::optional<Fuzzer::Crash> Fuzzer::fuzz() {
+    return run(_mutate());
+}
+
+const Fuzzer::Stats& Fuzzer::stats() const {
+    return _stats;
+}
+
+const std::vector<std::vector<uint8_t>>& Fuzzer::corpus() const {
+    return _corpus;
+}
+
+const std::map<std::pair<uint16_t, std::string>, Fuzzer::Crash>& Fuzzer::crashes() const {
+    return _crashes;
+}
@@ -0,0 +1,255 @@
+#include "../../inc/emulator/history.hpp"
+
+#include <algorithm>
+
+History::History(Machine& machine, Computer& core, size_t budget, std::chrono::milliseconds interval) :
+    _machine(machine),
+    _core(core),
+    _budget(budget),
+    _interval(interval),
+    _bytes(0),
+    _keep_input_log(false),
+    _recording(false),
+    _freq(std::numeric_limits<double>::infinity())
+{
+    _machine.add_input_ports(_input_log);
+    _core.attach_input_log(&_input_log);
+}
+
+History::~History() {
+    stop();
+    _core.attach_input_log(nullptr);
+}
+
+uint64_t History::_cycle() const {
+    return _core.get_state().cycle;
+}
+
+void History::_checkpoint() {
+    const uint64_t cycle = _cycle();
+    if (!_checkpoints.empty() && _checkpoints.back()->cores[0].cycle == cycle)
+        return;
+    _checkpoints.push_back(_machine.snapshot({ &_core }, !_checkpoints.empty()));
+    _bytes += _checkpoints.back()->bytes();
+    while (_bytes > _budget && _checkpoints.size() > 1)
+        _merge_oldest();
+}
+
+// fold a checkpoint into the next one, which is based on it
+void History::_merge(size_t index) {
+    const Snapshot& first = *_checkpoints[index];
+    Snapshot& next = *_checkpoints[index + 1];
+    _bytes -= first.bytes() + next.bytes();
+
+    std::vector<MemoryChunk> chunks;
+    chunks.reserve(first.chunks.size());
+    auto it = next.chunks.begin();
+    for (const MemoryChunk& chunk: first.chunks) {
+        while (it != next.chunks.end() && it->address < chunk.address)
+            chunks.push_back(*it++);
+        if (it != next.chunks.end() && it->address == chunk.address)
+            chunks.push_back(*it++);
+        else
+            chunks.push_back(chunk);
+    }
+    chunks.insert(chunks.end(), it, next.chunks.end());
+    next.chunks = std::move(chunks);
+    next.base = first.base;
+
+    _bytes += next.bytes();
+    _checkpoints.erase(_checkpoints.begin() + index);
+}
+
+// fold the oldest checkpoint (always a full snapshot) into the next one
+void History::_merge_oldest() {
+    _merge(0);
+    if (!_keep_input_log)
+        _input_log.discard_before(_checkpoints.front()->cores[0].cycle);
+}
+
+// drop checkpoints after the current cycle (they are taken again as the core replays the log)
+void History::_truncate() {
+    const uint64_t cycle = _cycle();
+    while (!_checkpoints.empty() && _checkpoints.back()->cores[0].cycle > cycle) {
+        _bytes -= _checkpoints.back()->bytes();
+        _checkpoints.pop_back();
+    }
+}
+
+// continue whatever the core was doing before the recorder stopped it
+void History::_resume() {
+    // a probe (e.g. a breakpoint) stopped the core by itself
+    if (_core.stopped_by_probe()) {
+        _recording = false;
+        return;
+    }
+    if (!_step_end.has_value()) {
+        _core.run(_freq);
+        return;
+    }
+    const uint64_t cycle = _cycle();
+    if (cycle < *_step_end)
+        _core.step(*_step_end - cycle);
+    else
+        _recording = false;
+}
+
+// return to a checkpoint, replaying the input log from there
+void History::_restore(const std::shared_ptr<const Snapshot>& checkpoint) {
+    _machine.restore(checkpoint, { &_core });
+    _input_log.seek(checkpoint->cores[0].cycle);
+}
+
+// run the core up to a cycle in full batches, calling stopped whenever search stops it
+// the other probes are muted: they have already seen this execution
+void History::_replay(uint64_t cycle, Probe* search, const std::function<void()>& stopped) {
+    struct Mute {
+        Computer& core;
+        Mute(Computer& core, Probe* search) : core(core) { core.mute_probes(true, search); }
+        ~Mute() { core.mute_probes(false); }
+    } mute(_core, search);
+
+    for (;;) {
+        const Computer::State state = _core.get_state();
+        if (state.cycle >= cycle)
+            return;
+        _core.step_sync(cycle - state.cycle);
+        if (_core.stopped_by_probe()) {
+            stopped();
+            continue;
+        }
+        // halted until an event, and the log has none before the cycle: the core sat halted until then
+        if (_cycle() == state.cycle) {
+            Computer::State halted = _core.get_state();
+            halted.cycle = cycle;
+            _core.set_state(halted);
+        }
+    }
+}
+
+void History::_record_worker() {
+    std::unique_lock lock(_mutex);
+    while (_recording) {
+        if (_wake_recorder.wait_for(lock, _interval, [this] { return !_recording; }))
+            break;
+        // nothing changes while the core is halted, and restarting it would wake its parked run thread
+        if (_core.halted())
+            continue;
+        _core.stop();
+        _checkpoint();
+        _resume();
+    }
+}
+
+void History::run(double freq) {
+    stop();
+    _checkpoint();
+    _freq = freq;
+    _step_end.reset();
+    _recording = true;
+    _core.run(freq);
+    _recorder = std::thread(&History::_record_worker, this);
+}
+
+void History::step(uint64_t count) {
+    stop();
+    _checkpoint();
+    _step_end = _cycle() + count;
+    _recording = true;
+    _core.step(count);
+    _recorder = std::thread(&History::_record_worker, this);
+}
+
+void History::stop() {
+    {
+        std::lock_guard lock(_mutex);
+        _recording = false;
+    }
+    _wake_recorder.notify_all();
+    if (_recorder.joinable())
+        _recorder.join();
+    _core.stop();
+}
+
+uint64_t History::step_back(uint64_t count) {
+    stop();
+    if (_checkpoints.empty())
+        return 0;
+    const uint64_t now = _cycle();
+    const uint64_t target = std::max(now - std::min(count, now), std::min(oldest(), now));
+
+    // last checkpoint at or before the target
+    auto it = std::upper_bound(_checkpoints.begin(), _checkpoints.end(), target, [] (uint64_t cycle, const auto& checkpoint) {
+        return cycle < checkpoint->cores[0].cycle;
+    });
+    _restore(*std::prev(it));
+    _replay(target);
+    _truncate();
+    return now - target;
+}
+
+bool History::reverse_until(const std::function<bool(const Computer::State&)>& stop) {
+    this->stop();
+
+    // evaluated by the core at every instruction boundary, stopping it at a match
+    struct Search: Probe {
+        const std::function<bool(const Computer::State&)>& stop;
+        Search(const std::function<bool(const Computer::State&)>& stop) : stop(stop) {}
+        bool instruction(const Computer::State& state) override { return stop(state); }
+    } search(stop);
+    struct Attach {
+        Computer& core;
+        Probe* probe;
+        Attach(Computer& core, Probe* probe) : core(core), probe(probe) { core.attach_probe(probe); }
+        ~Attach() { core.detach_probe(probe); }
+    } attach(_core, &search);
+
+    // search the spans between checkpoints from the latest back, replaying each once: every match
+    // takes a checkpoint there, and the previous match's is folded into it, so the span ends with
+    // one at its last match (the later checkpoints are dropped, as going back drops them anyway)
+    uint64_t end = _cycle();
+    for (size_t i = _checkpoints.size(); i-- != 0;) {
+        const std::shared_ptr<Snapshot> checkpoint = _checkpoints[i];
+        const uint64_t start = checkpoint->cores[0].cycle;
+        if (start >= end)
+            continue;
+
+        _restore(checkpoint);
+        _truncate();
+        std::optional<uint64_t> found;
+        _replay(end, &search, [&] {
+            const bool fold = found.has_value() && *found != start;
+            found = _cycle();
+            _checkpoint();
+            if (fold)
+                _merge(_checkpoints.size() - 2);
+        });
+        if (found.has_value()) {
+            _restore(_checkpoints.back());
+            return true;
+        }
+        end = start;
+    }
+
+    if (!_checkpoints.empty()) {
+        _restore(_checkpoints.front());
+        _truncate();
+    }
+    return false;
+}
+
+InputLog& History::input_log() {
+    return _input_log;
+}
+
+void History::keep_input_log(bool keep) {
+    _keep_input_log = keep;
+}
+
+size_t History::bytes() const {
+    return _bytes;
+}
+
+uint64_t History::oldest() const {
+    return _checkpoints.empty() ? _cycle() : _checkpoints.front()->cores[0].cycle;
+}
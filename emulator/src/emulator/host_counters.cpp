@@ -0,0 +1,85 @@
+#include "../../inc/emulator/host_counters.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <format>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static constexpr uint64_t EVENT_CONFIGS[HostCounters::EVENT_COUNT] {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_BRANCH_MISSES,
+    PERF_COUNT_HW_CACHE_MISSES,
+};
+
+static int perf_event_open(perf_event_attr& attr) {
+    return syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+}
+
+HostCounters::HostCounters() {
+    for (int event = 0; event < EVENT_COUNT; ++event) {
+        perf_event_attr attr {};
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = EVENT_CONFIGS[event];
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        _fds[event] = perf_event_open(attr);
+        if (_fds[event] == -1 && _error.empty())
+            _error = std::format("{}: {}", EVENT_NAMES[event], std::strerror(errno));
+    }
+}
+
+HostCounters::~HostCounters() {
+    for (const int fd: _fds) {
+        if (fd != -1)
+            close(fd);
+    }
+}
+
+bool HostCounters::available() const {
+    for (const int fd: _fds) {
+        if (fd != -1)
+            return true;
+    }
+    return false;
+}
+
+const std::string& HostCounters::error() const {
+    return _error;
+}
+
+HostCounters::Sample HostCounters::read() const {
+    Sample sample;
+    for (int event = 0; event < EVENT_COUNT; ++event) {
+        uint64_t values[3]; // value, time enabled, time running
+        if (_fds[event] == -1 || ::read(_fds[event], values, sizeof(values)) != sizeof(values))
+            continue;
+        if (values[2] == 0) // never scheduled on the PMU
+            sample.counts[event] = 0;
+        else
+            sample.counts[event] = values[2] == values[1] ? values[0] : static_cast<uint64_t>(static_cast<double>(values[0]) * values[1] / values[2]);
+    }
+    return sample;
+}
+
+void HostCounters::report(std::ostream& out, const Sample& begin, const Sample& end, uint64_t guest_instructions, uint64_t guest_cycles) {
+    out << std::format("Host counters over {} guest instructions, {} guest cycles:\n", guest_instructions, guest_cycles);
+    for (int event = 0; event < EVENT_COUNT; ++event) {
+        if (!begin.counts[event] || !end.counts[event]) {
+            out << std::format("  {:<14} unavailable\n", EVENT_NAMES[event]);
+            continue;
+        }
+        const uint64_t count = *end.counts[event] - *begin.counts[event];
+        out << std::format("  {:<14} {:>14}  {:>10.3f} per instruction  {:>10.3f} per cycle\n", EVENT_NAMES[event], count,
+            guest_instructions == 0 ? 0.0 : static_cast<double>(count) / guest_instructions,
+            guest_cycles == 0 ? 0.0 : static_cast<double>(count) / guest_cycles);
+    }
+}
@@ -0,0 +1,169 @@
+#include "../../inc/emulator/input_log.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+static constexpr char MAGIC[4] = { '8', 'B', 'I', 'L' };
+
+static void write_varint(std::ofstream& file, uint64_t x) {
+    while (x >= 0x80) {
+        file.put(static_cast<char>(x | 0x80));
+        x >>= 7;
+    }
+    file.put(static_cast<char>(x));
+}
+
+static uint64_t read_varint(std::ifstream& file) {
+    uint64_t x = 0;
+    for (unsigned int shift = 0; shift < 64; shift += 7) {
+        const int byte = file.get();
+        if (byte == std::char_traits<char>::eof())
+            throw std::runtime_error("InputLog: truncated file");
+        x |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+            return x;
+    }
+    throw std::runtime_error("InputLog: bad varint");
+}
+
+InputLog::InputLog() :
+    _next(0),
+    _replaying(false)
+{}
+
+void InputLog::add_port(size_t address, size_t size) {
+    _ports.emplace_back(address, size);
+}
+
+bool InputLog::is_port(size_t address) const {
+    return std::any_of(_ports.begin(), _ports.end(), [address] (const auto& port) {
+        return address - port.first < port.second;
+    });
+}
+
+bool InputLog::replaying() const {
+    return _replaying;
+}
+
+const std::vector<InputLog::Entry>& InputLog::entries() const {
+    return _entries;
+}
+
+uint64_t InputLog::end() const {
+    return _entries.empty() ? 0 : _entries.back().cycle;
+}
+
+void InputLog::record(const Entry& entry) {
+    _entries.push_back(entry);
+}
+
+void InputLog::record_stop(uint64_t cycle) {
+    if (!_replaying)
+        _entries.push_back({ cycle, Kind::STOP, 0, 0 });
+}
+
+// stops only mark where the original run paused, the core doesn't replay them
+void InputLog::_skip_stops() {
+    while (_next != _entries.size() && _entries[_next].kind == Kind::STOP)
+        ++_next;
+}
+
+// move to the next entry to replay, recording again once there are none
+void InputLog::_advance() {
+    _skip_stops();
+    if (_next == _entries.size())
+        _replaying = false;
+}
+
+const InputLog::Entry* InputLog::next() const {
+    return _next == _entries.size() ? nullptr : &_entries[_next];
+}
+
+void InputLog::pop() {
+    ++_next;
+    _advance();
+}
+
+void InputLog::rewind() {
+    _replaying = true;
+    _next = 0;
+    _advance();
+}
+
+void InputLog::seek(uint64_t cycle) {
+    _replaying = true;
+    _next = std::lower_bound(_entries.begin(), _entries.end(), cycle, [] (const Entry& entry, uint64_t cycle) {
+        return entry.cycle < cycle;
+    }) - _entries.begin();
+    _advance();
+}
+
+void InputLog::discard_before(uint64_t cycle) {
+    const auto end = std::lower_bound(_entries.begin(), _entries.end(), cycle, [] (const Entry& entry, uint64_t cycle) {
+        return entry.cycle < cycle;
+    });
+    const size_t n = end - _entries.begin();
+    _entries.erase(_entries.begin(), end);
+    _next -= std::min(_next, n);
+}
+
+// format: magic, port count, (address, size) per port, then (kind, cycle delta[, address, value]) per entry
+void InputLog::write(const std::string& filename) const {
+    std::ofstream file(filename, file.binary);
+    if (!file)
+        throw std::runtime_error("InputLog: cannot open " + filename);
+    file.write(MAGIC, sizeof(MAGIC));
+    write_varint(file, _ports.size());
+    for (const auto& [address, size]: _ports) {
+        write_varint(file, address);
+        write_varint(file, size);
+    }
+    uint64_t cycle = 0;
+    for (const Entry& entry: _entries) {
+        file.put(static_cast<char>(entry.kind));
+        write_varint(file, entry.cycle - cycle);
+        cycle = entry.cycle;
+        if (entry.kind == Kind::READ) {
+            write_varint(file, entry.address);
+            file.put(static_cast<char>(entry.value));
+        }
+    }
+}
+
+void InputLog::read(const std::string& filename) {
+    std::ifstream file(filename, file.binary);
+    char magic[sizeof(MAGIC)];
+    if (!file.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), MAGIC))
+        throw std::runtime_error("InputLog: " + filename + " is not an input log");
+
+    // every port takes at least two bytes, so a larger count is a corrupt file, not an allocation to try
+    const uint64_t ports = read_varint(file);
+    const std::streampos start = file.tellg();
+    file.seekg(0, file.end);
+    const uint64_t remaining = file.tellg() - start;
+    file.seekg(start);
+    if (ports > remaining / 2)
+        throw std::runtime_error("InputLog: bad file " + filename);
+    _ports.resize(ports);
+    for (auto& [address, size]: _ports) {
+        address = read_varint(file);
+        size = read_varint(file);
+    }
+    _entries.clear();
+    uint64_t cycle = 0;
+    for (int kind; (kind = file.get()) != std::char_traits<char>::eof();) {
+        if (kind > static_cast<int>(Kind::STOP))
+            throw std::runtime_error("InputLog: bad entry in " + filename);
+        cycle += read_varint(file);
+        Entry& entry = _entries.emplace_back(cycle, static_cast<Kind>(kind), 0, 0);
+        if (entry.kind == Kind::READ) {
+            entry.address = read_varint(file);
+            const int value = file.get();
+            if (value == std::char_traits<char>::eof())
+                throw std::runtime_error("InputLog: truncated file " + filename);
+            entry.value = value;
+        }
+    }
+    rewind();
+}
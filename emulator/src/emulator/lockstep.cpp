@@ -0,0 +1,208 @@
+#include "../../inc/emulator/lockstep.hpp"
+
+#include <cstring>
+#include <format>
+#include <stdexcept>
+
+static const char* REGISTER_NAMES[16] {
+    "ra.l", "ra.h", "sr", "sp", "fp", "gb", "gc", "gd",
+    "ge.l", "ge.h", "gf.l", "gf.h", "gg.l", "gg.h", "gh.l", "gh.h",
+};
+
+// The machine's bus as the core sees it, keeping the writes since the last clear.
+class Lockstep::WriteLog: public MemoryDevice {
+private:
+    MemoryDevicePointer _bus;
+
+public:
+    std::vector<Write> writes;
+
+    WriteLog(const MemoryDevicePointer& bus) :
+        MemoryDevice(bus->access),
+        _bus(bus)
+    {}
+
+    size_t size() const override {
+        return _bus->size();
+    }
+
+    void debug_write(size_t address, uint8_t value) override {
+        _bus->debug_write(address, value);
+    }
+
+    MemoryResult read(size_t address) const override {
+        return _bus->read(address);
+    }
+
+    MemoryResult write(size_t address, uint8_t value) override {
+        writes.push_back({ static_cast<uint16_t>(address), value });
+        return _bus->write(address, value);
+    }
+};
+
+bool Lockstep::NullProbe::instruction(const Computer::State&) {
+    return false;
+}
+
+Lockstep::Core::Core(Engine engine) :
+    bus(new WriteLog(machine.memory))
+{
+    computer.attach_memory(bus);
+    computer.debug_init();
+    computer.reset();
+    blank = machine.snapshot({ &computer });
+    if (engine == Engine::CHECKED)
+        computer.attach_probe(&probe);
+}
+
+Lockstep::Core::~Core() {
+    computer.detach_probe(&probe);
+}
+
+std::vector<Lockstep::Write>& Lockstep::Core::writes() {
+    return bus.get<WriteLog>().writes;
+}
+
+void Lockstep::Core::load(const MemoryMap& map) {
+    // only copies back the pages written since the last load, and snapshots leave out the rom
+    machine.restore(blank, { &computer });
+    for (size_t address = Machine::ROM_ADDRESS; address < Machine::ROM_ADDRESS + Machine::ROM_SIZE; ++address)
+        machine.memory->debug_write(address, 0);
+    machine.load(map);
+    computer.reset();
+}
+
+std::string Lockstep::Core::step() {
+    try {
+        computer.step_sync(CYCLES_PER_INSTRUCTION);
+    } catch (const std::runtime_error& e) {
+        return e.what();
+    }
+    return {};
+}
+
+// everything that carries over from one instruction to the next (the pipeline latches don't)
+static bool same_state(const Computer::State& a, const Computer::State& b) {
+    return a.cycle == b.cycle && a.pc == b.pc && a.stage == b.stage && a.halted == b.halted && a.wake_cycle == b.wake_cycle
+        && std::memcmp(a.registers, b.registers, sizeof(a.registers)) == 0;
+}
+
+static std::string format_writes(const std::vector<Lockstep::Write>& writes) {
+    std::string s;
+    for (const Lockstep::Write& write: writes)
+        s += std::format(" [{:04x}]={:02x}", write.address, write.value);
+    return s.empty() ? " none" : s;
+}
+
+std::string Lockstep::Divergence::describe() const {
+    const Computer::State& r = reference.state;
+    const Computer::State& t = test.state;
+    std::string s = std::format("diverged after {} instructions, at cycle {} pc {:04x} (instruction {:04x})\n",
+        instructions, before.cycle, before.pc, r.instruction);
+    auto line = [&s] (const char* what, const std::string& a, const std::string& b) {
+        if (a != b)
+            s += std::format("  {:<8} reference {:<12} test {}\n", what, a, b);
+    };
+    line("pc", std::format("{:04x}", r.pc), std::format("{:04x}", t.pc));
+    for (int i = 0; i < 16; ++i)
+        line(REGISTER_NAMES[i], std::format("{:02x}", r.registers[i]), std::format("{:02x}", t.registers[i]));
+    line("cycle", std::to_string(r.cycle), std::to_string(t.cycle));
+    line("stage", std::to_string(r.stage), std::to_string(t.stage));
+    line("halted", r.halted ? std::format("wake {}", r.wake_cycle) : "no", t.halted ? std::format("wake {}", t.wake_cycle) : "no");
+    if (reference.writes != test.writes)
+        s += std::format("  writes   reference{}\n           test{}\n", format_writes(reference.writes), format_writes(test.writes));
+    if (reference.error != test.error)
+        s += std::format("  error    reference \"{}\"\n           test \"{}\"\n", reference.error, test.error);
+    return s;
+}
+
+Lockstep::Lockstep(Engine reference, Engine test) :
+    _reference(std::make_unique<Core>(reference)),
+    _test(std::make_unique<Core>(test)),
+    _state(),
+    _instructions(0),
+    _finished(false)
+{}
+
+Lockstep::~Lockstep() = default;
+
+void Lockstep::load(const MemoryMap& map) {
+    _reference->load(map);
+    _test->load(map);
+    _image = map;
+    _origin.reset();
+    _state = _reference->computer.get_state();
+    _instructions = 0;
+    _finished = false;
+}
+
+void Lockstep::restore(const std::shared_ptr<const Snapshot>& snapshot) {
+    if (snapshot->cores.size() != 1)
+        throw std::invalid_argument("Lockstep::restore(): the snapshot must have a single core");
+    _reference->machine.restore(snapshot, { &_reference->computer });
+    _test->machine.restore(snapshot, { &_test->computer });
+    _image.reset();
+    _origin = snapshot;
+    _state = _reference->computer.get_state();
+    _instructions = 0;
+    _finished = false;
+}
+
+std::optional<Lockstep::Divergence> Lockstep::run(uint64_t count) {
+    for (uint64_t i = 0; i < count && !_finished; ++i) {
+        _reference->writes().clear();
+        _test->writes().clear();
+        std::string reference_error = _reference->step();
+        std::string test_error = _test->step();
+        const Computer::State reference = _reference->computer.get_state();
+        const Computer::State test = _test->computer.get_state();
+
+        if (!same_state(reference, test) || _reference->writes() != _test->writes() || reference_error != test_error) {
+            return Divergence {
+                _instructions,
+                _state,
+                { reference, std::move(_reference->writes()), std::move(reference_error) },
+                { test, std::move(_test->writes()), std::move(test_error) },
+            };
+        }
+
+        _state = reference;
+        ++_instructions;
+        // nothing but an event could move either core on, and none will come
+        _finished = !reference_error.empty() || (reference.halted && reference.wake_cycle == 0);
+    }
+    return std::nullopt;
+}
+
+uint64_t Lockstep::instructions() const {
+    return _instructions;
+}
+
+bool Lockstep::finished() const {
+    return _finished;
+}
+
+std::shared_ptr<Snapshot> Lockstep::replay_reference(uint64_t count) {
+    Core& core = *_reference;
+    if (_origin != nullptr)
+        core.machine.restore(_origin, { &core.computer });
+    else
+        core.load(*_image);
+    for (uint64_t i = 0; i < count; ++i) {
+        if (!core.step().empty())
+            throw std::logic_error("Lockstep::replay_reference(): replay threw before the divergence");
+    }
+    return core.machine.snapshot({ &core.computer });
+}
+
+std::optional<Lockstep::Engine> Lockstep::parse_engine(const std::string& name) {
+    if (name == "unchecked")
+        return Engine::UNCHECKED;
+    if (name == "checked")
+        return Engine::CHECKED;
+    return std::nullopt;
+}
+
+const char* Lockstep::engine_name(Engine engine) {
+    return engine == Engine::CHECKED ? "checked" : "unchecked";
+}
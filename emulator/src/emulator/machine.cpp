@@ -0,0 +1,128 @@
+#include "../../inc/emulator/machine.hpp"
+
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+
+Machine::Machine(ImageCache& cache) :
+    _cache(cache),
+    _rom(new PagedMemoryDevice(ROM_SIZE, MemoryDevice::Access::READ_ONLY, cache)),
+    _ram(new PagedMemoryDevice(IO_ADDRESS - RAM_ADDRESS, MemoryDevice::Access::READ_WRITE, cache)),
+    _keyboard(new KeyboardDevice()),
+    screen(80, 50),
+    memory(new InterfaceDevice(MemoryDevice::Access::READ_WRITE))
+{
+    const size_t screen_memory_size = screen.memory().size();
+
+    MemoryDevicePointer io = new InterfaceDevice(MemoryDevice::Access::READ_WRITE);
+    // wait register halting the core that writes it
+    io.get<InterfaceDevice>().add_device(WAIT_ADDRESS - IO_ADDRESS, new WaitDevice());
+    // keyboard input queue
+    io.get<InterfaceDevice>().add_device(KEYBOARD_ADDRESS - IO_ADDRESS, _keyboard);
+    // atomic test-and-set locks at the end of the io page
+    io.get<InterfaceDevice>().add_device(LOCK_ADDRESS - IO_ADDRESS, new TestAndSetDevice(LOCK_COUNT));
+
+    // bootloader rom 0x0000 to 0x00FF
+    memory.get<InterfaceDevice>().add_device(ROM_ADDRESS, _rom);
+    // main memory 0x0100 to before start of io page
+    memory.get<InterfaceDevice>().add_device(RAM_ADDRESS, _ram);
+    // io page 0xDF00 to 0xDFFF
+    memory.get<InterfaceDevice>().add_device(IO_ADDRESS, io);
+    // map screen character memory from end of io page to end of address space
+    memory.get<InterfaceDevice>().add_device(0x10000 - screen_memory_size, &screen.memory());
+}
+
+void Machine::load(const MemoryMap& map) {
+    static_assert(RAM_ADDRESS % MEMORY_PAGE_SIZE == 0 && IO_ADDRESS % MEMORY_PAGE_SIZE == 0);
+
+    // build the final contents of every rom and ram page the image touches
+    std::map<size_t, MemoryPage> touched;
+    for (const auto& section: map) {
+        size_t address = section.first;
+        for (uint8_t byte: section.second) {
+            if (address >= IO_ADDRESS) {
+                memory->debug_write(address++, byte);
+                continue;
+            }
+            auto [it, inserted] = touched.try_emplace(address / MEMORY_PAGE_SIZE);
+            if (inserted) {
+                const bool rom = address < RAM_ADDRESS;
+                PagedMemoryDevice& device = (rom ? _rom : _ram).get<PagedMemoryDevice>();
+                it->second = device.page((address - (rom ? ROM_ADDRESS : RAM_ADDRESS)) / MEMORY_PAGE_SIZE);
+            }
+            it->second[address % MEMORY_PAGE_SIZE] = byte;
+            ++address;
+        }
+    }
+
+    for (const auto& [page, data]: touched) {
+        const size_t address = page * MEMORY_PAGE_SIZE;
+        const bool rom = address < RAM_ADDRESS;
+        PagedMemoryDevice& device = (rom ? _rom : _ram).get<PagedMemoryDevice>();
+        device.share((address - (rom ? ROM_ADDRESS : RAM_ADDRESS)) / MEMORY_PAGE_SIZE, _cache.intern(data));
+    }
+}
+
+KeyboardDevice& Machine::keyboard() {
+    return _keyboard.get<KeyboardDevice>();
+}
+
+void Machine::add_input_ports(InputLog& log) const {
+    log.add_port(KEYBOARD_ADDRESS, 1);
+}
+
+std::vector<Machine::Region> Machine::regions() const {
+    static_assert(ROM_ADDRESS % MEMORY_PAGE_SIZE == 0 && ROM_SIZE % MEMORY_PAGE_SIZE == 0 && IO_SIZE % MEMORY_PAGE_SIZE == 0);
+    // screen memory ends the address space, starting part way into its first page
+    const size_t screen_address = 0x10000 - screen.memory().size();
+    return {
+        { "rom", ROM_ADDRESS / MEMORY_PAGE_SIZE, (ROM_ADDRESS + ROM_SIZE) / MEMORY_PAGE_SIZE },
+        { "ram", RAM_ADDRESS / MEMORY_PAGE_SIZE, IO_ADDRESS / MEMORY_PAGE_SIZE },
+        { "io", IO_ADDRESS / MEMORY_PAGE_SIZE, (IO_ADDRESS + IO_SIZE) / MEMORY_PAGE_SIZE },
+        { "screen", screen_address / MEMORY_PAGE_SIZE, 0x10000 / MEMORY_PAGE_SIZE },
+    };
+}
+
+std::shared_ptr<Snapshot> Machine::snapshot(const std::vector<Computer*>& cores, bool incremental) {
+    auto snapshot = std::make_shared<Snapshot>();
+    for (const Computer* core: cores)
+        snapshot->cores.push_back(core->get_state());
+    if (incremental)
+        snapshot->base = _epoch;
+    memory->save(0, snapshot->chunks, snapshot->base != nullptr);
+    memory->clean();
+    _epoch = snapshot;
+    return snapshot;
+}
+
+void Machine::restore(const std::shared_ptr<const Snapshot>& snapshot, const std::vector<Computer*>& cores) {
+    if (snapshot->cores.size() != cores.size())
+        throw std::invalid_argument("Machine::restore(): snapshot has a different number of cores");
+
+    const Snapshot* epoch = _epoch.get();
+    while (epoch != nullptr && epoch != snapshot.get())
+        epoch = epoch->base.get();
+
+    std::vector<size_t> addresses;
+    if (epoch != nullptr) {
+        // only chunks written since the snapshot can differ from it
+        memory->dirty(0, addresses);
+        for (const Snapshot* s = _epoch.get(); s != snapshot.get(); s = s->base.get())
+            for (const MemoryChunk& chunk: s->chunks)
+                addresses.push_back(chunk.address);
+        std::sort(addresses.begin(), addresses.end());
+        addresses.erase(std::unique(addresses.begin(), addresses.end()), addresses.end());
+    } else {
+        addresses = snapshot->addresses();
+    }
+
+    for (size_t address: addresses) {
+        if (const MemoryChunk* chunk = snapshot->find(address))
+            memory->restore(address, chunk->data.data(), chunk->size);
+    }
+    memory->clean();
+    _epoch = snapshot;
+
+    for (size_t i = 0; i < cores.size(); ++i)
+        cores[i]->set_state(snapshot->cores[i]);
+}
@@ -1,5 +1,8 @@
 #include "../../inc/emulator/memory.hpp"
 
+#include <algorithm>
+#include <cstring>
+
 MemoryResult::MemoryResult(uint8_t value) :
     signal(Signal::SUCCESS),
     value(value)
@@ -34,6 +37,22 @@ MemoryResult MemoryDevice::read(size_t) const {
     return { MemoryResult::Signal::CANNOT_READ };
 }
 
+void MemoryDevice::save(size_t, std::vector<MemoryChunk>&, bool) const {
+
+}
+
+void MemoryDevice::dirty(size_t, std::vector<size_t>&) const {
+
+}
+
+void MemoryDevice::clean() {
+
+}
+
+void MemoryDevice::restore(size_t, const uint8_t*, size_t) {
+
+}
+
 void MemoryDevice::debug_fill(size_t size, uint8_t value) {
     for (size_t i = 0; i < size; ++i)
         debug_write(i, value);
@@ -177,16 +196,46 @@ MemoryResult InterfaceDevice::write(size_t address, uint8_t value) {
     return entry->device->write(address - entry->address, value);
 }
 
+void InterfaceDevice::save(size_t base, std::vector<MemoryChunk>& chunks, bool dirty_only) const {
+    for (const Entry& entry: table)
+        entry.device->save(base + entry.address, chunks, dirty_only);
+}
+
+void InterfaceDevice::dirty(size_t base, std::vector<size_t>& addresses) const {
+    for (const Entry& entry: table)
+        entry.device->dirty(base + entry.address, addresses);
+}
+
+void InterfaceDevice::clean() {
+    for (const Entry& entry: table)
+        entry.device->clean();
+}
+
+void InterfaceDevice::restore(size_t address, const uint8_t* data, size_t size) {
+    const Entry* entry = resolve_address(address);
+    if (entry == nullptr)
+        return;
+    entry->device->restore(address - entry->address, data, size);
+}
+
 
 
 BufferMemoryDevice::BufferMemoryDevice(size_t size, Access access) :
     MemoryDevice(access),
     _size(size),
-    data(new uint8_t[size])
+    data(new uint8_t[size]),
+    written((size + MEMORY_PAGE_SIZE - 1) / MEMORY_PAGE_SIZE, false)
 {
     std::fill_n(&data[0], _size, 0);
 }
 
+void BufferMemoryDevice::mark_written(size_t page) {
+    if (!written[page]) {
+        written[page] = true;
+        written_pages.push_back(page);
+    }
+}
+
 size_t BufferMemoryDevice::size() const {
     return _size;
 }
@@ -196,6 +245,7 @@ void BufferMemoryDevice::debug_write(size_t address, uint8_t value) {
         return;
     MSSpinLockGuard guard(lock, MSSpinLockGuard::Type::SLAVE);
     data[address] = value;
+    mark_written(address / MEMORY_PAGE_SIZE);
 }
 
 MemoryResult BufferMemoryDevice::read(size_t address) const {
@@ -216,6 +266,133 @@ MemoryResult BufferMemoryDevice::write(size_t address, uint8_t value) {
         return { MemoryResult::Signal::OUT_OF_RANGE };
     MSSpinLockGuard guard(lock, MSSpinLockGuard::Type::SLAVE);
     data[address] = value;
+    mark_written(address / MEMORY_PAGE_SIZE);
     // std::cout << "Wrote "  << +value << " to address " << address << '\n';
     return {};
+}
+
+
+void BufferMemoryDevice::save(size_t base, std::vector<MemoryChunk>& chunks, bool dirty_only) const {
+    MSSpinLockGuard guard(lock, MSSpinLockGuard::Type::MASTER);
+    for (size_t page = 0; page < written.size(); ++page) {
+        if (dirty_only && !written[page])
+            continue;
+        const size_t address = page * MEMORY_PAGE_SIZE;
+        MemoryChunk& chunk = chunks.emplace_back(base + address, std::min(MEMORY_PAGE_SIZE, _size - address));
+        std::memcpy(chunk.data.data(), &data[address], chunk.size);
+    }
+}
+
+void BufferMemoryDevice::dirty(size_t base, std::vector<size_t>& addresses) const {
+    MSSpinLockGuard guard(lock, MSSpinLockGuard::Type::MASTER);
+    for (size_t page: written_pages)
+        addresses.push_back(base + page * MEMORY_PAGE_SIZE);
+}
+
+void BufferMemoryDevice::clean() {
+    MSSpinLockGuard guard(lock, MSSpinLockGuard::Type::MASTER);
+    for (size_t page: written_pages)
+        written[page] = false;
+    written_pages.clear();
+}
+
+void BufferMemoryDevice::restore(size_t address, const uint8_t* data, size_t size) {
+    if (address >= _size)
+        return;
+    MSSpinLockGuard guard(lock, MSSpinLockGuard::Type::MASTER);
+    std::memcpy(&this->data[address], data, std::min(size, _size - address));
+}
+
+
+
+TestAndSetDevice::TestAndSetDevice(size_t size) :
+    MemoryDevice(Access::READ_WRITE),
+    _size(size),
+    cells(new std::atomic_uint8_t[size])
+{
+    for (size_t i = 0; i < _size; ++i)
+        cells[i].store(0, std::memory_order_relaxed);
+}
+
+size_t TestAndSetDevice::size() const {
+    return _size;
+}
+
+void TestAndSetDevice::debug_write(size_t address, uint8_t value) {
+    if (address >= _size)
+        return;
+    cells[address].store(value, std::memory_order_relaxed);
+}
+
+MemoryResult TestAndSetDevice::read(size_t address) const {
+    if (address >= _size)
+        return { MemoryResult::Signal::OUT_OF_RANGE };
+    return cells[address].exchange(1, std::memory_order_acq_rel);
+}
+
+MemoryResult TestAndSetDevice::write(size_t address, uint8_t value) {
+    if (address >= _size)
+        return { MemoryResult::Signal::OUT_OF_RANGE };
+    cells[address].store(value, std::memory_order_release);
+    return {};
+}
+
+void TestAndSetDevice::save(size_t base, std::vector<MemoryChunk>& chunks, bool) const {
+    for (size_t address = 0; address < _size; address += MEMORY_PAGE_SIZE) {
+        MemoryChunk& chunk = chunks.emplace_back(base + address, std::min(MEMORY_PAGE_SIZE, _size - address));
+        for (size_t i = 0; i < chunk.size; ++i)
+            chunk.data[i] = cells[address + i].load(std::memory_order_relaxed);
+    }
+}
+
+void TestAndSetDevice::dirty(size_t base, std::vector<size_t>& addresses) const {
+    for (size_t address = 0; address < _size; address += MEMORY_PAGE_SIZE)
+        addresses.push_back(base + address);
+}
+
+void TestAndSetDevice::restore(size_t address, const uint8_t* data, size_t size) {
+    for (size_t i = 0; i < size && address + i < _size; ++i)
+        cells[address + i].store(data[i], std::memory_order_relaxed);
+}
+
+
+
+WaitDevice::WaitDevice() :
+    MemoryDevice(Access::WRITE_ONLY)
+{}
+
+size_t WaitDevice::size() const {
+    return 1;
+}
+
+MemoryResult WaitDevice::write(size_t address, uint8_t value) {
+    if (address >= 1)
+        return { MemoryResult::Signal::OUT_OF_RANGE };
+    return { MemoryResult::Signal::WAIT, value };
+}
+
+
+
+KeyboardDevice::KeyboardDevice() :
+    MemoryDevice(Access::READ_ONLY)
+{}
+
+size_t KeyboardDevice::size() const {
+    return 1;
+}
+
+MemoryResult KeyboardDevice::read(size_t address) const {
+    if (address >= 1)
+        return { MemoryResult::Signal::OUT_OF_RANGE };
+    MSSpinLockGuard guard(lock, MSSpinLockGuard::Type::SLAVE);
+    if (keys.empty())
+        return 0;
+    const uint8_t key = keys.front();
+    keys.pop_front();
+    return key;
+}
+
+void KeyboardDevice::push(uint8_t key) {
+    MSSpinLockGuard guard(lock, MSSpinLockGuard::Type::MASTER);
+    keys.push_back(key);
 }
\ No newline at end of file
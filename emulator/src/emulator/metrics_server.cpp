@@ -0,0 +1,219 @@
+#include "../../inc/emulator/metrics_server.hpp"
+#include "../../inc/emulator/spinlock.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+#include <utility>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static constexpr int REQUEST_TIMEOUT_MS = 100; // for a request before answering in plain text
+
+static std::runtime_error socket_error(const std::string& what, const std::string& path) {
+    return std::runtime_error(std::format("MetricsServer: cannot {} {}: {}", what, path, std::strerror(errno)));
+}
+
+MetricsServer::MetricsServer(const std::string& path, const std::vector<Computer*>& cores, const std::vector<Machine::Region>& regions) :
+    _path(path),
+    _cores(cores),
+    _regions(regions),
+    _start(std::chrono::steady_clock::now()),
+    _socket(-1),
+    _stop_pipe { -1, -1 }
+{
+    sockaddr_un address {};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path))
+        throw std::runtime_error("MetricsServer: socket path too long: " + path);
+    std::strcpy(address.sun_path, path.c_str());
+
+    // a socket left by an earlier run is replaced, anything else is not
+    struct stat st;
+    if (lstat(path.c_str(), &st) == 0) {
+        if (!S_ISSOCK(st.st_mode))
+            throw std::runtime_error("MetricsServer: not a socket: " + path);
+        unlink(path.c_str());
+    }
+
+    _socket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (_socket == -1)
+        throw socket_error("create", path);
+    if (bind(_socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == -1 || listen(_socket, 8) == -1) {
+        const std::runtime_error error = socket_error("listen on", path);
+        close(_socket);
+        throw error;
+    }
+    if (pipe2(_stop_pipe, O_CLOEXEC) == -1) {
+        const std::runtime_error error = socket_error("create a pipe for", path);
+        close(_socket);
+        unlink(path.c_str());
+        throw error;
+    }
+
+    for (Computer* core: _cores) {
+        _accesses.push_back(std::make_unique<Computer::PageAccesses>());
+        core->attach_page_accesses(_accesses.back().get());
+    }
+
+    _previous = _last = _sample();
+    _thread = std::thread(&MetricsServer::_worker, this);
+}
+
+MetricsServer::~MetricsServer() {
+    close(_stop_pipe[1]);
+    _thread.join();
+    for (Computer* core: _cores)
+        core->attach_page_accesses(nullptr);
+    close(_stop_pipe[0]);
+    close(_socket);
+    unlink(_path.c_str());
+}
+
+MetricsServer::Sample MetricsServer::_sample() const {
+    Sample sample { std::chrono::steady_clock::now(), {}, {} };
+    for (const Computer* core: _cores) {
+        const uint64_t cycles = core->peek_cycle();
+        uint64_t instructions = 0;
+        if constexpr (Computer::STATISTICS) {
+            const Computer::Statistics statistics = core->peek_statistics();
+            for (const uint64_t count: statistics.formats)
+                instructions += count;
+        } else {
+            instructions = cycles / 5;
+        }
+        sample.cycles.push_back(cycles);
+        sample.instructions.push_back(instructions);
+    }
+    return sample;
+}
+
+std::string MetricsServer::_render() const {
+    const Sample now = _sample();
+    const double period = std::chrono::duration<double>(_last.time - _previous.time).count();
+    // counts go backwards when a core is reset or restored
+    auto rate = [period] (uint64_t last, uint64_t previous) {
+        return period == 0.0 || last < previous ? 0.0 : (last - previous) / period;
+    };
+
+    std::string text;
+    text += "# HELP emulator_uptime_seconds Time since the metrics server started.\n";
+    text += "# TYPE emulator_uptime_seconds gauge\n";
+    text += std::format("emulator_uptime_seconds {:.3f}\n", std::chrono::duration<double>(now.time - _start).count());
+
+    text += "# HELP emulator_cycles_total Guest cycles run, as of the end of the core's last batch.\n";
+    text += "# TYPE emulator_cycles_total counter\n";
+    for (size_t i = 0; i < _cores.size(); ++i)
+        text += std::format("emulator_cycles_total{{core=\"{}\"}} {}\n", i, now.cycles[i]);
+
+    text += Computer::STATISTICS
+        ? "# HELP emulator_instructions_total Guest instructions run.\n"
+        : "# HELP emulator_instructions_total Guest instructions run, estimated at five cycles each (exact with STATISTICS=1).\n";
+    text += "# TYPE emulator_instructions_total counter\n";
+    for (size_t i = 0; i < _cores.size(); ++i)
+        text += std::format("emulator_instructions_total{{core=\"{}\"}} {}\n", i, now.instructions[i]);
+
+    text += std::format("# HELP emulator_frequency_hertz Guest cycles per second over the last {} ms.\n", SAMPLE_PERIOD.count());
+    text += "# TYPE emulator_frequency_hertz gauge\n";
+    for (size_t i = 0; i < _cores.size(); ++i)
+        text += std::format("emulator_frequency_hertz{{core=\"{}\"}} {:.0f}\n", i, rate(_last.cycles[i], _previous.cycles[i]));
+
+    text += std::format("# HELP emulator_instructions_per_second Guest instructions per second over the last {} ms.\n", SAMPLE_PERIOD.count());
+    text += "# TYPE emulator_instructions_per_second gauge\n";
+    for (size_t i = 0; i < _cores.size(); ++i)
+        text += std::format("emulator_instructions_per_second{{core=\"{}\"}} {:.0f}\n", i, rate(_last.instructions[i], _previous.instructions[i]));
+
+    const MSSpinLock::Waits waits = MSSpinLock::waits();
+    text += "# HELP emulator_lock_waits_total Emulator lock acquisitions that had to wait.\n";
+    text += "# TYPE emulator_lock_waits_total counter\n";
+    text += std::format("emulator_lock_waits_total {}\n", waits.count);
+    text += "# HELP emulator_lock_wait_seconds_total Time spent waiting for emulator locks.\n";
+    text += "# TYPE emulator_lock_wait_seconds_total counter\n";
+    text += std::format("emulator_lock_wait_seconds_total {:.9f}\n", waits.ns / 1e9);
+
+    std::string loads, stores;
+    for (size_t i = 0; i < _cores.size(); ++i) {
+        Computer::PageAccesses& accesses = *_accesses[i];
+        for (const Machine::Region& region: _regions) {
+            uint64_t region_loads = 0, region_stores = 0;
+            for (size_t page = region.first_page; page < region.end_page; ++page) {
+                region_loads += std::atomic_ref<uint64_t>(accesses.loads[page]).load(std::memory_order_relaxed);
+                region_stores += std::atomic_ref<uint64_t>(accesses.stores[page]).load(std::memory_order_relaxed);
+            }
+            loads += std::format("emulator_device_loads_total{{core=\"{}\",device=\"{}\"}} {}\n", i, region.name, region_loads);
+            stores += std::format("emulator_device_stores_total{{core=\"{}\",device=\"{}\"}} {}\n", i, region.name, region_stores);
+        }
+    }
+    text += "# HELP emulator_device_loads_total Guest loads by device.\n";
+    text += "# TYPE emulator_device_loads_total counter\n";
+    text += loads;
+    text += "# HELP emulator_device_stores_total Guest stores by device.\n";
+    text += "# TYPE emulator_device_stores_total counter\n";
+    text += stores;
+    return text;
+}
+
+void MetricsServer::_serve(int connection) const {
+    // give the client a moment to send a request, then answer whatever it sent
+    char request[1024];
+    ssize_t received = 0;
+    pollfd readable { connection, POLLIN, 0 };
+    if (poll(&readable, 1, REQUEST_TIMEOUT_MS) == 1)
+        received = recv(connection, request, sizeof(request), 0);
+    const bool http = received >= 4 && std::memcmp(request, "GET ", 4) == 0;
+
+    const std::string body = _render();
+    std::string response;
+    if (http)
+        response = std::format("HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: {}\r\nConnection: close\r\n\r\n", body.size());
+    response += body;
+
+    for (size_t sent = 0; sent < response.size();) {
+        const ssize_t n = send(connection, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+        if (n == -1) {
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+        sent += n;
+    }
+}
+
+void MetricsServer::_worker() {
+    auto next_sample = _last.time + SAMPLE_PERIOD;
+    while (true) {
+        const auto now = std::chrono::steady_clock::now();
+        if (now >= next_sample) {
+            _previous = std::exchange(_last, _sample());
+            next_sample += SAMPLE_PERIOD;
+            if (next_sample <= now)
+                next_sample = now + SAMPLE_PERIOD;
+        }
+
+        const int timeout = std::chrono::ceil<std::chrono::milliseconds>(next_sample - now).count();
+        pollfd fds[2] { { _socket, POLLIN, 0 }, { _stop_pipe[0], POLLIN, 0 } };
+        if (poll(fds, 2, std::max(timeout, 0)) == -1) {
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+        // the write end closes on destruction
+        if (fds[1].revents != 0)
+            return;
+        if (fds[0].revents & POLLIN) {
+            const int connection = accept4(_socket, nullptr, nullptr, SOCK_CLOEXEC);
+            if (connection != -1) {
+                _serve(connection);
+                close(connection);
+            }
+        }
+    }
+}
@@ -0,0 +1,165 @@
+#include "../../inc/emulator/paged_memory.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+static constexpr size_t PURGE_INTERVAL = 4096;
+
+ImageCache::ImageCache() :
+    _inserts_since_purge(0)
+{}
+
+ImageCache& ImageCache::global() {
+    static ImageCache cache;
+    return cache;
+}
+
+// drop entries for pages no instance uses anymore
+void ImageCache::_purge() {
+    std::erase_if(_pages, [] (const auto& entry) {
+        return entry.second.expired();
+    });
+    _inserts_since_purge = 0;
+}
+
+std::shared_ptr<const MemoryPage> ImageCache::intern(const MemoryPage& page) {
+    std::string key(reinterpret_cast<const char*>(page.data()), page.size());
+    std::lock_guard guard(_mutex);
+    auto& entry = _pages[std::move(key)];
+    if (auto shared = entry.lock())
+        return shared;
+    auto shared = std::make_shared<const MemoryPage>(page);
+    entry = shared;
+    if (++_inserts_since_purge == PURGE_INTERVAL)
+        _purge();
+    return shared;
+}
+
+
+
+PagedMemoryDevice::PagedMemoryDevice(size_t size, Access access, ImageCache& cache) :
+    MemoryDevice(access),
+    _size(size),
+    pages((size + MEMORY_PAGE_SIZE - 1) / MEMORY_PAGE_SIZE, cache.intern(MemoryPage{})),
+    owned(pages.size(), false),
+    written(pages.size(), false)
+{}
+
+MemoryPage& PagedMemoryDevice::_own(size_t page) {
+    if (!owned[page]) {
+        pages[page] = std::make_shared<MemoryPage>(*pages[page]);
+        owned[page] = true;
+    }
+    // private pages are allocated non-const above
+    return const_cast<MemoryPage&>(*pages[page]);
+}
+
+void PagedMemoryDevice::_mark_written(size_t page) {
+    if (!written[page]) {
+        written[page] = true;
+        written_pages.push_back(page);
+    }
+}
+
+size_t PagedMemoryDevice::size() const {
+    return _size;
+}
+
+void PagedMemoryDevice::debug_write(size_t address, uint8_t value) {
+    if (address >= _size)
+        return;
+    MSSpinLockGuard guard(lock, MSSpinLockGuard::Type::SLAVE);
+    const size_t page = address / MEMORY_PAGE_SIZE;
+    const size_t offset = address % MEMORY_PAGE_SIZE;
+    // don't unshare a page for a write that changes nothing (e.g. clearing memory)
+    if ((*pages[page])[offset] == value)
+        return;
+    _own(page)[offset] = value;
+    _mark_written(page);
+}
+
+MemoryResult PagedMemoryDevice::read(size_t address) const {
+    if (!((int)access & (int)Access::READ_ONLY))
+        return { MemoryResult::Signal::CANNOT_READ };
+    if (address >= _size)
+        return { MemoryResult::Signal::OUT_OF_RANGE };
+    MSSpinLockGuard guard(lock, MSSpinLockGuard::Type::SLAVE);
+    return (*pages[address / MEMORY_PAGE_SIZE])[address % MEMORY_PAGE_SIZE];
+}
+
+MemoryResult PagedMemoryDevice::write(size_t address, uint8_t value) {
+    if (!((int)access & (int)Access::WRITE_ONLY))
+        return { MemoryResult::Signal::CANNOT_WRITE };
+    if (address >= _size)
+        return { MemoryResult::Signal::OUT_OF_RANGE };
+    MSSpinLockGuard guard(lock, MSSpinLockGuard::Type::SLAVE);
+    const size_t page = address / MEMORY_PAGE_SIZE;
+    _own(page)[address % MEMORY_PAGE_SIZE] = value;
+    _mark_written(page);
+    return {};
+}
+
+void PagedMemoryDevice::share(size_t page, const std::shared_ptr<const MemoryPage>& data) {
+    if (page >= pages.size())
+        throw std::out_of_range("PagedMemoryDevice: page out of range");
+    MSSpinLockGuard guard(lock, MSSpinLockGuard::Type::SLAVE);
+    pages[page] = data;
+    owned[page] = false;
+    _mark_written(page);
+}
+
+void PagedMemoryDevice::save(size_t base, std::vector<MemoryChunk>& chunks, bool dirty_only) const {
+    if (!((int)access & (int)Access::WRITE_ONLY))
+        return;
+    MSSpinLockGuard guard(lock, MSSpinLockGuard::Type::MASTER);
+    for (size_t page = 0; page < pages.size(); ++page) {
+        if (dirty_only && !written[page])
+            continue;
+        const size_t address = page * MEMORY_PAGE_SIZE;
+        chunks.emplace_back(base + address, std::min(MEMORY_PAGE_SIZE, _size - address), *pages[page]);
+    }
+}
+
+void PagedMemoryDevice::dirty(size_t base, std::vector<size_t>& addresses) const {
+    if (!((int)access & (int)Access::WRITE_ONLY))
+        return;
+    MSSpinLockGuard guard(lock, MSSpinLockGuard::Type::MASTER);
+    for (size_t page: written_pages)
+        addresses.push_back(base + page * MEMORY_PAGE_SIZE);
+}
+
+void PagedMemoryDevice::clean() {
+    MSSpinLockGuard guard(lock, MSSpinLockGuard::Type::MASTER);
+    for (size_t page: written_pages)
+        written[page] = false;
+    written_pages.clear();
+}
+
+void PagedMemoryDevice::restore(size_t address, const uint8_t* data, size_t size) {
+    if (address >= _size)
+        return;
+    MSSpinLockGuard guard(lock, MSSpinLockGuard::Type::MASTER);
+    size = std::min(size, _size - address);
+    while (size != 0) {
+        const size_t page = address / MEMORY_PAGE_SIZE;
+        const size_t offset = address % MEMORY_PAGE_SIZE;
+        const size_t n = std::min(size, MEMORY_PAGE_SIZE - offset);
+        // skip the copy (and unsharing the page) if nothing changed
+        if (std::memcmp(pages[page]->data() + offset, data, n) != 0)
+            std::memcpy(_own(page).data() + offset, data, n);
+        address += n;
+        data += n;
+        size -= n;
+    }
+}
+
+MemoryPage PagedMemoryDevice::page(size_t page) const {
+    MSSpinLockGuard guard(lock, MSSpinLockGuard::Type::SLAVE);
+    return *pages[page];
+}
+
+size_t PagedMemoryDevice::owned_pages() const {
+    MSSpinLockGuard guard(lock, MSSpinLockGuard::Type::SLAVE);
+    return std::count(owned.begin(), owned.end(), true);
+}
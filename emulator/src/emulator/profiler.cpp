@@ -0,0 +1,96 @@
+#include "../../inc/emulator/profiler.hpp"
+#include "../../../common/inc/encoding.hpp"
+
+#include <algorithm>
+#include <format>
+#include <map>
+#include <string>
+#include <vector>
+
+static constexpr const char* CLASS_NAMES[Profiler::CLASS_COUNT] {
+    "alu", "alu immediate", "load", "store", "jump", "call",
+};
+
+Profiler::Profiler() {
+    clear();
+}
+
+void Profiler::clear() {
+    _counts.fill(0);
+    _classes.fill(0);
+}
+
+void Profiler::merge(const Profiler& other) {
+    for (size_t pc = 0; pc < _counts.size(); ++pc)
+        _counts[pc] += other._counts[pc];
+    for (size_t c = 0; c < CLASS_COUNT; ++c)
+        _classes[c] += other._classes[c];
+}
+
+uint64_t Profiler::count(uint16_t pc) const {
+    return _counts[pc];
+}
+
+uint64_t Profiler::count(Class c) const {
+    return _classes[*c];
+}
+
+uint64_t Profiler::total() const {
+    uint64_t total = 0;
+    for (const uint64_t count: _counts)
+        total += count;
+    return total;
+}
+
+const char* Profiler::class_name(Class c) {
+    return CLASS_NAMES[*c];
+}
+
+void Profiler::report(std::ostream& out, const SymbolTable& symbols, size_t top) const {
+    const uint64_t total = this->total();
+    if (total == 0) {
+        out << "No instructions executed.\n";
+        return;
+    }
+    const auto percent = [total] (uint64_t count) {
+        return 100.0 * count / total;
+    };
+
+    std::vector<std::pair<uint64_t, uint16_t>> hot;
+    std::map<std::string, uint64_t> labels;
+    for (size_t pc = 0; pc < _counts.size(); ++pc) {
+        if (_counts[pc] == 0)
+            continue;
+        hot.emplace_back(_counts[pc], pc);
+        const auto location = symbols.find(pc);
+        labels[location.has_value() ? *location->label : "?"] += _counts[pc];
+    }
+
+    const auto by_count = [] (const auto& a, const auto& b) {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    };
+    top = std::min(top, hot.size());
+    std::partial_sort(hot.begin(), hot.begin() + top, hot.end(), by_count);
+
+    out << std::format("{} instructions, {} cycles\n\n", total, total * 5);
+    out << std::format("{:>14} {:>7}  {:<6} {}\n", "count", "%", "pc", "location");
+    for (size_t i = 0; i < top; ++i) {
+        const auto [count, pc] = hot[i];
+        out << std::format("{:>14} {:>6.2f}%  {:04x}   {}\n", count, percent(count), pc, symbols.format(pc));
+    }
+
+    if (!symbols.empty()) {
+        std::vector<std::pair<uint64_t, std::string>> functions;
+        for (const auto& [label, count]: labels)
+            functions.emplace_back(count, label);
+        const size_t top_functions = std::min(top, functions.size());
+        std::partial_sort(functions.begin(), functions.begin() + top_functions, functions.end(), by_count);
+        out << std::format("\n{:>14} {:>7}  {}\n", "count", "%", "label");
+        for (size_t i = 0; i < top_functions; ++i)
+            out << std::format("{:>14} {:>6.2f}%  {}\n", functions[i].first, percent(functions[i].first), functions[i].second);
+    }
+
+    out << std::format("\n{:>14} {:>7}  {}\n", "count", "%", "class");
+    for (size_t c = 0; c < CLASS_COUNT; ++c)
+        out << std::format("{:>14} {:>6.2f}%  {}\n", _classes[c], percent(_classes[c]), CLASS_NAMES[c]);
+}
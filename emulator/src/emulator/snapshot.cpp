@@ -0,0 +1,86 @@
+#include "../../inc/emulator/snapshot.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+template <typename T>
+static void bin_write(std::ofstream& file, const T& x) {
+    file.write(reinterpret_cast<const char*>(&x), sizeof(T));
+}
+
+template <typename T>
+static T bin_read(std::ifstream& file) {
+    T x;
+    file.read(reinterpret_cast<char*>(&x), sizeof(T));
+    return x;
+}
+
+const MemoryChunk* Snapshot::find(size_t address) const {
+    for (const Snapshot* snapshot = this; snapshot != nullptr; snapshot = snapshot->base.get()) {
+        auto it = std::lower_bound(snapshot->chunks.begin(), snapshot->chunks.end(), address, [] (const MemoryChunk& chunk, size_t address) {
+            return chunk.address < address;
+        });
+        if (it != snapshot->chunks.end() && it->address == address)
+            return &*it;
+    }
+    return nullptr;
+}
+
+std::vector<size_t> Snapshot::addresses() const {
+    const Snapshot* root = this;
+    while (root->base)
+        root = root->base.get();
+    std::vector<size_t> addresses;
+    addresses.reserve(root->chunks.size());
+    for (const MemoryChunk& chunk: root->chunks)
+        addresses.push_back(chunk.address);
+    return addresses;
+}
+
+size_t Snapshot::bytes() const {
+    return sizeof(Snapshot) + cores.size() * sizeof(Computer::State) + chunks.size() * sizeof(MemoryChunk);
+}
+
+// format: core count, core states, then (address, size, bytes) for every chunk
+void Snapshot::write(const std::string& filename) const {
+    std::ofstream file(filename, file.binary);
+    if (!file)
+        throw std::runtime_error("Snapshot: cannot open " + filename);
+    bin_write<uint64_t>(file, cores.size());
+    for (const Computer::State& state: cores)
+        bin_write(file, state);
+    for (size_t address: addresses()) {
+        const MemoryChunk* chunk = find(address);
+        bin_write<uint64_t>(file, chunk->address);
+        bin_write<uint64_t>(file, chunk->size);
+        file.write(reinterpret_cast<const char*>(chunk->data.data()), chunk->size);
+    }
+    if (!file.flush())
+        throw std::runtime_error("Snapshot: cannot write " + filename);
+}
+
+void Snapshot::read(const std::string& filename) {
+    std::ifstream file(filename, file.binary);
+    if (!file)
+        throw std::runtime_error("Snapshot: cannot open " + filename);
+    cores.resize(bin_read<uint64_t>(file));
+    for (Computer::State& state: cores)
+        state = bin_read<Computer::State>(file);
+    if (!file)
+        throw std::runtime_error("Snapshot: truncated file " + filename);
+    chunks.clear();
+    base = nullptr;
+    for (;;) {
+        const size_t address = bin_read<uint64_t>(file);
+        const size_t size = bin_read<uint64_t>(file);
+        if (file.eof())
+            break;
+        if (size > MEMORY_PAGE_SIZE)
+            throw std::runtime_error("Snapshot: bad chunk in " + filename);
+        MemoryChunk& chunk = chunks.emplace_back(address, size);
+        file.read(reinterpret_cast<char*>(chunk.data.data()), size);
+        if (!file)
+            throw std::runtime_error("Snapshot: truncated file " + filename);
+    }
+}
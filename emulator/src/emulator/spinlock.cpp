@@ -1,17 +1,32 @@
 #include "../../inc/emulator/spinlock.hpp"
+#include "../../inc/emulator/event_trace.hpp"
 #include <atomic>
 
-void MSSpinLock::_acquire() {
-    while (_lock.test_and_set(std::memory_order_acquire))
-        _lock.wait(true, std::memory_order_relaxed);
+std::atomic_uint64_t MSSpinLock::_wait_count = 0;
+std::atomic_uint64_t MSSpinLock::_wait_ns = 0;
+
+void MSSpinLock::_acquire(std::optional<uint64_t>& wait_begin) {
+    while (_lock.test_and_set(std::memory_order_acquire)) {
+        if (!wait_begin.has_value())
+            wait_begin = EventTrace::now();
+        _waiters.fetch_add(1);
+        _lock.wait(true);
+        _waiters.fetch_sub(1);
+    }
 }
 
 void MSSpinLock::_release() {
-    _lock.clear(std::memory_order_release);
-    _lock.notify_all();
+    // seq_cst on both sides: either a waiter sees the lock cleared or the release sees the waiter
+    _lock.clear();
+    if (_waiters.load() != 0)
+        _lock.notify_all();
 }
 
-MSSpinLock::MSSpinLock() : _master(false), _lock(false) {}
+MSSpinLock::MSSpinLock() : _master(false), _lock(false), _waiters(0) {}
+
+MSSpinLock::Waits MSSpinLock::waits() {
+    return { _wait_count.load(std::memory_order_relaxed), _wait_ns.load(std::memory_order_relaxed) };
+}
 
 MSSpinLockGuard::MSSpinLockGuard() : _lock(nullptr) {}
 
@@ -29,11 +44,27 @@ void MSSpinLockGuard::acquire(MSSpinLock& lock, Type type) {
         release();
     _type = type;
     _lock = &lock;
+    // only a wait reads the clock
+    std::optional<uint64_t> wait_begin;
     if (_type == Type::MASTER)
         _lock->_master.fetch_add(1, std::memory_order_relaxed);
-    else while (uint64_t x = _lock->_master.load(std::memory_order_relaxed))
-        _lock->_master.wait(x, std::memory_order_relaxed);
-    _lock->_acquire();
+    else while (uint64_t x = _lock->_master.load()) {
+        if (!wait_begin.has_value())
+            wait_begin = EventTrace::now();
+        _lock->_waiters.fetch_add(1);
+        _lock->_master.wait(x);
+        _lock->_waiters.fetch_sub(1);
+    }
+    _lock->_acquire(wait_begin);
+    if (!wait_begin.has_value())
+        return;
+
+    // waits add to the process totals, and show on the event trace if one is started
+    const uint64_t end = EventTrace::now();
+    MSSpinLock::_wait_count.fetch_add(1, std::memory_order_relaxed);
+    MSSpinLock::_wait_ns.fetch_add(end - *wait_begin, std::memory_order_relaxed);
+    if (EventTrace* trace = EventTrace::active())
+        trace->span(_type == Type::MASTER ? "lock wait (master)" : "lock wait (slave)", "lock", *wait_begin, end, EventTrace::HOST, EventTrace::thread_track());
 }
 
 void MSSpinLockGuard::release() {
@@ -41,7 +72,7 @@ void MSSpinLockGuard::release() {
         return;
     _lock->_release();
     if (_type == Type::MASTER) {
-        if (_lock->_master.fetch_sub(1, std::memory_order_relaxed) == 1)
+        if (_lock->_master.fetch_sub(1) == 1 && _lock->_waiters.load() != 0)
             _lock->_master.notify_all();
     }
     _lock = nullptr;
@@ -0,0 +1,318 @@
+#include "../../inc/emulator/tracer.hpp"
+#include "../../../common/inc/encoding.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <stdexcept>
+
+static constexpr char MAGIC[4] = { '8', 'B', 'T', 'R' };
+static constexpr uint8_t VERSION = 2;
+
+// Every record starts with a byte of these flags, followed by the fields the flags don't make implicit.
+enum EncodedFlag : uint8_t {
+    PC_NEXT = 1 << 0, // pc follows the previous instruction, else a zigzag varint from there
+    CYCLE_SAME = 1 << 1, // took as many cycles as the previous one, else a varint cycle delta
+    INSN_CACHED = 1 << 2, // same instruction as last time at this pc, else 2 bytes
+    ENC_REG = 1 << 3, // reg and value bytes
+    ENC_READ = 1 << 4, // zigzag varint address delta and value byte
+    ENC_WRITE = 1 << 5, // same
+    SR_CHANGED = 1 << 6, // sr byte
+    ENC_RA = 1 << 7, // zigzag varint ra from the next instruction (usually 0)
+};
+
+// State shared by the encoder and the decoder: each record is encoded against the previous one.
+struct TraceCodec {
+    uint64_t cycle = 0;
+    uint64_t cycle_delta = 0;
+    uint16_t pc = 0xFFFE;
+    uint16_t address = 0;
+    uint8_t sr = 0;
+    std::array<uint16_t, 0x10000> instructions {};
+
+    void encode(const Tracer::Record& record, std::string& out);
+    bool decode(std::ifstream& file, Tracer::Record& record);
+};
+
+static void write_varint(std::string& out, uint64_t x) {
+    while (x >= 0x80) {
+        out.push_back(static_cast<char>(x | 0x80));
+        x >>= 7;
+    }
+    out.push_back(static_cast<char>(x));
+}
+
+static uint8_t read_byte(std::ifstream& file) {
+    const int byte = file.get();
+    if (byte == std::char_traits<char>::eof())
+        throw std::runtime_error("TraceReader: truncated file");
+    return byte;
+}
+
+static uint64_t read_varint(std::ifstream& file) {
+    uint64_t x = 0;
+    for (unsigned int shift = 0; shift < 64; shift += 7) {
+        const uint8_t byte = read_byte(file);
+        x |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+            return x;
+    }
+    throw std::runtime_error("TraceReader: bad varint");
+}
+
+static uint16_t zigzag(int16_t x) {
+    return (static_cast<uint16_t>(x) << 1) ^ static_cast<uint16_t>(x >> 15);
+}
+
+static int16_t unzigzag(uint16_t x) {
+    return static_cast<int16_t>((x >> 1) ^ -(x & 1));
+}
+
+void TraceCodec::encode(const Tracer::Record& record, std::string& out) {
+    const size_t start = out.size();
+    out.push_back(0);
+    uint8_t flags = 0;
+
+    const uint64_t delta = record.cycle - cycle;
+    if (delta == cycle_delta)
+        flags |= CYCLE_SAME;
+    else
+        write_varint(out, delta);
+    cycle = record.cycle;
+    cycle_delta = delta;
+
+    const uint16_t next = pc + 2;
+    if (record.pc == next)
+        flags |= PC_NEXT;
+    else
+        write_varint(out, zigzag(record.pc - next));
+    pc = record.pc;
+
+    if (instructions[record.pc] == record.instruction) {
+        flags |= INSN_CACHED;
+    } else {
+        out.push_back(static_cast<char>(record.instruction));
+        out.push_back(static_cast<char>(record.instruction >> 8));
+        instructions[record.pc] = record.instruction;
+    }
+
+    if (record.flags & Tracer::REG) {
+        flags |= ENC_REG;
+        out.push_back(static_cast<char>(record.reg));
+        out.push_back(static_cast<char>(record.reg_value));
+    }
+
+    if (record.flags & (Tracer::READ | Tracer::WRITE)) {
+        flags |= record.flags & Tracer::READ ? ENC_READ : ENC_WRITE;
+        write_varint(out, zigzag(record.address - address));
+        out.push_back(static_cast<char>(record.mem_value));
+        address = record.address;
+    }
+
+    if (record.flags & Tracer::RA) {
+        flags |= ENC_RA;
+        write_varint(out, zigzag(record.ra - (record.pc + 2)));
+    }
+
+    if (record.sr != sr) {
+        flags |= SR_CHANGED;
+        out.push_back(static_cast<char>(record.sr));
+        sr = record.sr;
+    }
+
+    out[start] = static_cast<char>(flags);
+}
+
+bool TraceCodec::decode(std::ifstream& file, Tracer::Record& record) {
+    const int byte = file.get();
+    if (byte == std::char_traits<char>::eof())
+        return false;
+    const uint8_t flags = byte;
+    record = {};
+
+    if (!(flags & CYCLE_SAME))
+        cycle_delta = read_varint(file);
+    cycle += cycle_delta;
+    record.cycle = cycle;
+
+    pc += 2;
+    if (!(flags & PC_NEXT))
+        pc += unzigzag(read_varint(file));
+    record.pc = pc;
+
+    if (!(flags & INSN_CACHED)) {
+        const uint8_t low = read_byte(file);
+        instructions[pc] = low | read_byte(file) << 8;
+    }
+    record.instruction = instructions[pc];
+
+    if (flags & ENC_REG) {
+        record.flags |= Tracer::REG;
+        record.reg = read_byte(file);
+        record.reg_value = read_byte(file);
+    }
+
+    if (flags & (ENC_READ | ENC_WRITE)) {
+        record.flags |= flags & ENC_READ ? Tracer::READ : Tracer::WRITE;
+        address += unzigzag(read_varint(file));
+        record.address = address;
+        record.mem_value = read_byte(file);
+    }
+
+    if (flags & ENC_RA) {
+        record.flags |= Tracer::RA;
+        record.ra = pc + 2 + unzigzag(read_varint(file));
+    }
+
+    if (flags & SR_CHANGED)
+        sr = read_byte(file);
+    record.sr = sr;
+    return true;
+}
+
+Tracer::Tracer(Computer& core, const std::string& filename, const Filter& filter) :
+    _core(core),
+    _filter(filter),
+    _file(filename, std::ios::binary),
+    _codec(std::make_unique<TraceCodec>()),
+    _ring(std::make_unique<Record[]>(RING_SIZE)),
+    _head(0),
+    _tail_seen(0),
+    _current(),
+    _tracing_current(false),
+    _tail(0),
+    _closing(false),
+    _write_failed(false)
+{
+    if (!_file)
+        throw std::runtime_error("Tracer: cannot open " + filename);
+    _file.write(MAGIC, sizeof(MAGIC));
+    _file.put(static_cast<char>(VERSION));
+    _writer = std::thread(&Tracer::_write_worker, this);
+    _core.attach_probe(this);
+}
+
+Tracer::~Tracer() {
+    try {
+        close();
+    } catch (const std::exception&) {
+        // nowhere to report it from a destructor, call close() to find out
+    }
+}
+
+void Tracer::close() {
+    if (!_writer.joinable())
+        return;
+    _core.detach_probe(this);
+    if (_tracing_current) {
+        // a probe stopping the core at a boundary leaves the record opened there for an instruction
+        // that never ran
+        const Computer::State state = _core.get_state();
+        const bool ran = !(_core.stopped_by_probe() && state.cycle == _current.cycle);
+        if (state.stage == 0 && ran)
+            _finish(state);
+        _tracing_current = false;
+    }
+    _closing.store(true, std::memory_order_release);
+    _writer.join();
+    _file.close();
+    if (_write_failed || _file.fail())
+        throw std::runtime_error("Tracer: cannot write the trace");
+}
+
+uint64_t Tracer::records() const {
+    return _head.load(std::memory_order_relaxed);
+}
+
+// Fill in the results of the current instruction from the state at the end of it: the pipeline
+// registers still describe the instruction that just finished.
+void Tracer::_finish(const Computer::State& state) {
+    _current.instruction = state.instruction;
+    if (state.alu_write) {
+        _current.flags |= REG;
+        _current.reg = state.write_reg;
+        _current.reg_value = state.registers[state.write_reg];
+    }
+    if (state.mem_op == *MemOp::LOAD) {
+        _current.flags |= READ;
+        _current.mem_value = state.registers[state.write_reg];
+    } else if (state.mem_op == *MemOp::STORE) {
+        _current.flags |= WRITE;
+        _current.mem_value = state.store_val;
+    }
+    if (state.save_ret) {
+        _current.flags |= RA;
+        _current.ra = state.registers[*Register::RA_L] | state.registers[*Register::RA_H] << 8;
+    }
+    _current.sr = state.registers[*Register::SR];
+    _push(_current);
+}
+
+void Tracer::_push(const Record& record) {
+    const uint64_t head = _head.load(std::memory_order_relaxed);
+    if (head - _tail_seen == RING_SIZE) {
+        // only look at the writer's position when the ring seems full, it's on another cache line
+        while ((_tail_seen = _tail.load(std::memory_order_acquire)) == head - RING_SIZE)
+            std::this_thread::yield();
+    }
+    _ring[head % RING_SIZE] = record;
+    _head.store(head + 1, std::memory_order_release);
+}
+
+void Tracer::_write_worker() {
+    std::string buffer;
+    uint64_t tail = 0;
+    for (;;) {
+        const bool closing = _closing.load(std::memory_order_acquire);
+        const uint64_t head = _head.load(std::memory_order_acquire);
+        if (head == tail) {
+            if (closing)
+                break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        buffer.clear();
+        for (; tail != head; ++tail)
+            _codec->encode(_ring[tail % RING_SIZE], buffer);
+        _tail.store(tail, std::memory_order_release);
+        if (!_write_failed && !_file.write(buffer.data(), buffer.size()))
+            _write_failed = true;
+    }
+}
+
+bool Tracer::instruction(const Computer::State& state) {
+    if (_tracing_current)
+        _finish(state);
+    _tracing_current = state.pc - _filter.first_pc <= _filter.last_pc - _filter.first_pc
+        && state.cycle - _filter.begin_cycle < _filter.end_cycle - _filter.begin_cycle;
+    if (_tracing_current) {
+        _current.cycle = state.cycle;
+        _current.pc = state.pc;
+        _current.flags = 0;
+    }
+    return false;
+}
+
+bool Tracer::access(const Computer::State&, uint16_t address, bool) {
+    _current.address = address;
+    return false;
+}
+
+TraceReader::TraceReader(const std::string& filename) :
+    _file(filename, std::ios::binary),
+    _codec(std::make_unique<TraceCodec>())
+{
+    if (!_file)
+        throw std::runtime_error("TraceReader: cannot open " + filename);
+    char magic[sizeof(MAGIC)];
+    if (!_file.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), MAGIC))
+        throw std::runtime_error("TraceReader: " + filename + " is not a trace");
+    if (_file.get() != VERSION)
+        throw std::runtime_error("TraceReader: unsupported trace version in " + filename);
+}
+
+TraceReader::~TraceReader() = default;
+
+bool TraceReader::next(Tracer::Record& record) {
+    return _codec->decode(_file, record);
+}
@@ -1,12 +1,17 @@
 #include <SFML/System/String.hpp>
 #include <SFML/Window/WindowEnums.hpp>
 #include <atomic>
+#include <cctype>
 #include <cstdint>
+#include <format>
 #include <fstream>
 #include <functional>
 #include <initializer_list>
 #include <iostream>
 #include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <thread>
 
 #include <SFML/Graphics.hpp>
@@ -17,9 +22,15 @@
 #include <vector>
 
 #include "../../../common/inc/memorymap.hpp"
-#include "../../inc/emulator/screen.hpp"
+#include "../../inc/emulator/breakpoints.hpp"
+#include "../../inc/emulator/call_timeline.hpp"
 #include "../../inc/emulator/computer.hpp"
+#include "../../inc/emulator/condition.hpp"
+#include "../../inc/emulator/event_trace.hpp"
+#include "../../inc/emulator/history.hpp"
+#include "../../inc/emulator/machine.hpp"
 #include "../../inc/frontend/screen_renderer.hpp"
+#include "../../inc/utils/arg_parse.hpp"
 #include "../../inc/utils/split.hpp"
 
 using namespace std::chrono_literals;
@@ -37,37 +48,111 @@ std::vector<uint8_t> read_binary(const std::string& filename) {
 }
 
 int main(int argc, const char* argv[]) {
-    if (argc != 2) {
-        std::cerr << "Usage: " << argv[0] << " <program binary>\n";
+    ArgParse arg_parse(argc, argv);
+    auto history_str = arg_parse.take_option("--history");
+    auto record_file = arg_parse.take_option("--record");
+    auto timeline_file = arg_parse.take_option("--timeline");
+    auto symbols_file = arg_parse.take_option("--symbols");
+    auto program_file = arg_parse.take_normal();
+    if (arg_parse.get_error() || arg_parse.has_remaining() || !program_file.has_value()) {
+        std::cerr << "Usage: " << argv[0] << " <program binary> [--history <MiB>] [--record <input log>] [--timeline <trace file>] [--symbols <symbol file>]\n";
         return EINVAL;
     }
 
+    // checkpoints for going backwards, within a memory budget
+    size_t history_budget = History::DEFAULT_BUDGET;
+    if (history_str.has_value()) {
+        const std::optional<uint64_t> mib = ArgParse::parse_number(*history_str);
+        if (!mib.has_value() || *mib > std::numeric_limits<size_t>::max() >> 20) {
+            std::cerr << "Invalid history budget: " << *history_str << '\n';
+            return EINVAL;
+        }
+        history_budget = *mib << 20;
+    }
+
+    SymbolTable symbols;
+    if (symbols_file.has_value()) {
+        try {
+            symbols.read(*symbols_file);
+        } catch (const std::runtime_error& e) {
+            std::cerr << e.what() << '\n';
+            return EIO;
+        }
+    }
+
     Computer computer;
 
-    Screen screen(80, 50);
-    ScreenRenderer screen_renderer(&screen, 0, 0, 2.0f);
-    const size_t screen_memory_size = screen.memory().size();
-    
-    MemoryDevicePointer memory_interface = new InterfaceDevice(MemoryDevice::Access::READ_WRITE);
-    // bootloader rom 0x0000 to 0x00FF
-    memory_interface.get<InterfaceDevice>().add_device(0x0000, new BufferMemoryDevice(0x0100, MemoryDevice::Access::READ_ONLY));
-    // main memory 0x0100 to before start of screen character memory
-    memory_interface.get<InterfaceDevice>().add_device(0x0100, new BufferMemoryDevice(0xFF00 - screen_memory_size, MemoryDevice::Access::READ_WRITE));
-    // map screen character memory from end of main memory to end of address space
-    memory_interface.get<InterfaceDevice>().add_device(0x10000 - screen_memory_size, &screen.memory());
-
-    computer.attach_memory(memory_interface);
+    Machine machine;
+    ScreenRenderer screen_renderer(&machine.screen, 0, 0, 2.0f);
+
+    computer.attach_memory(machine.memory);
     computer.debug_init();
 
     MemoryMap map;
-    map.read(argv[1]);
-    memory_interface->debug_write(map);
-
-    // memory_interface->debug_write<Endian::LITTLE>(0x0000, read_binary("./DEBUG_BOOTLOADER.bin"));
-    // memory_interface->debug_write<Endian::BIG>(0x0300, read_binary(argv[1]));
+    try {
+        map.read(*program_file);
+    } catch (const std::runtime_error& e) {
+        std::cerr << e.what() << '\n';
+        return EIO;
+    }
+    machine.load(map);
 
     computer.reset();
 
+    History history(machine, computer, history_budget);
+
+    // before the timeline starts, so nothing returns early while a core may still record spans to it
+    sf::Font font;
+    if (!font.openFromFile("./fonts/Hack-Regular.ttf")) {
+        std::cerr << "Failed to open font.\n";
+        return 1;
+    }
+
+    // timeline of the gui and the emulator thread, written when the window closes, and of the guest's
+    // calls when there are symbols to name them (they attach a probe, which needs the checked engine)
+    EventTrace timeline;
+    std::optional<CallTimeline> call_timeline;
+    if (timeline_file.has_value()) {
+        timeline.start();
+        timeline.name_thread("gui");
+        if (symbols_file.has_value()) {
+            call_timeline.emplace(timeline, symbols, 0);
+            computer.attach_probe(&*call_timeline);
+        }
+    }
+
+    // the history logs keyboard input anyway; keep all of it for replaying the session with emulator_headless --replay
+    InputLog& input_log = history.input_log();
+    if (record_file.has_value())
+        history.keep_input_log();
+
+    // the breakpoints probe is only attached while there are any, so the core runs at full speed otherwise
+    Breakpoints breakpoints;
+    bool breakpoints_attached = false;
+    auto update_breakpoints = [&] () {
+        if (breakpoints.empty() == breakpoints_attached) {
+            if (breakpoints_attached)
+                computer.detach_probe(&breakpoints);
+            else
+                computer.attach_probe(&breakpoints);
+            breakpoints_attached = !breakpoints_attached;
+        }
+    };
+
+    // condition of the current "run until", reported by the window loop once met
+    std::mutex until_mutex;
+    std::shared_ptr<StopCondition> until;
+    bool until_reported = false;
+    auto set_until = [&] (const std::shared_ptr<StopCondition>& condition) {
+        std::lock_guard lock(until_mutex);
+        if (until)
+            computer.detach_probe(until.get());
+        until = condition;
+        until_reported = false;
+        if (until)
+            computer.attach_probe(until.get());
+    };
+
     std::atomic_bool exit;
 
     auto input_thread_worker = [&] () {
@@ -92,7 +177,128 @@ int main(int argc, const char* argv[]) {
                     args = { "step" };
                     return;
                 }
-                computer.step(n);
+                if (computer.halted())
+                    computer.wake();
+                set_until(nullptr);
+                history.step(n);
+            }},
+            { "back", [&] () {
+                int64_t n = 1;
+                if (args.size() == 2) {
+                    try {
+                        n = std::stoll(args[1]);
+                    } catch (const std::exception& e) {
+                        n = -1;
+                    }
+                }
+                if (args.size() > 2 || n < 0) {
+                    std::cerr << "Invalid command.\n";
+                    args = { "step" };
+                    return;
+                }
+                const uint64_t back = history.step_back(n);
+                if (back < static_cast<uint64_t>(n))
+                    std::cout << "Went back " << back << " cycles (reached the oldest checkpoint).\n";
+            }},
+            { "rcontinue", [&] () {
+                if (args.size() < 2) {
+                    std::cerr << "Invalid command.\n";
+                    args = { "step" };
+                    return;
+                }
+                // a lone number is an address, anything else a condition
+                std::string expression;
+                for (size_t i = 1; i < args.size(); ++i)
+                    expression += args[i] + ' ';
+                if (args.size() == 2 && std::isdigit((unsigned char)args[1][0]))
+                    expression = "pc == " + expression;
+                std::optional<Condition> condition;
+                try {
+                    condition.emplace(expression);
+                } catch (const std::invalid_argument& e) {
+                    std::cerr << "Invalid condition: " << e.what() << '\n';
+                    args = { "step" };
+                    return;
+                }
+                if (!history.reverse_until([&] (const Computer::State& state) { return condition->evaluate(state, *machine.memory) != 0; }))
+                    std::cout << "Condition not met, went back to the oldest checkpoint.\n";
+            }},
+            { "break", [&] () {
+                unsigned long address = 0x10000;
+                if (args.size() == 2) {
+                    try {
+                        address = std::stoul(args[1], nullptr, 0);
+                    } catch (const std::exception& e) {}
+                }
+                if (args.size() != 2 || address > 0xFFFF) {
+                    std::cerr << "Invalid command.\n";
+                    args = { "step" };
+                    return;
+                }
+                const size_t id = breakpoints.add(address, address, Breakpoints::BREAK);
+                update_breakpoints();
+                std::cout << std::format("Breakpoint {} at {:04x}.\n", id, address);
+                args = { "step" };
+            }},
+            { "watch", [&] () {
+                static const std::unordered_map<std::string, uint8_t> KINDS {
+                    { "r", Breakpoints::READ },
+                    { "w", Breakpoints::WRITE },
+                    { "rw", Breakpoints::READ | Breakpoints::WRITE },
+                };
+                unsigned long address = 0x10000;
+                unsigned long size = 1;
+                auto kinds = KINDS.find("w");
+                if (args.size() >= 2 && args.size() <= 4) {
+                    try {
+                        address = std::stoul(args[1], nullptr, 0);
+                        if (args.size() >= 3)
+                            size = std::stoul(args[2], nullptr, 0);
+                    } catch (const std::exception& e) {
+                        address = 0x10000;
+                    }
+                    if (args.size() == 4)
+                        kinds = KINDS.find(args[3]);
+                }
+                if (address > 0xFFFF || size == 0 || address + size > 0x10000 || kinds == KINDS.end()) {
+                    std::cerr << "Invalid command.\n";
+                    args = { "step" };
+                    return;
+                }
+                const size_t id = breakpoints.add(address, address + size - 1, kinds->second);
+                update_breakpoints();
+                std::cout << std::format("Watchpoint {} on {:04x}-{:04x} ({}).\n", id, address, address + size - 1, kinds->first);
+                args = { "step" };
+            }},
+            { "delete", [&] () {
+                unsigned long id = 0;
+                if (args.size() == 2) {
+                    try {
+                        id = std::stoul(args[1]);
+                    } catch (const std::exception& e) {}
+                }
+                if (args.size() > 2 || (args.size() == 2 && !breakpoints.remove(id))) {
+                    std::cerr << "Invalid command.\n";
+                    args = { "step" };
+                    return;
+                }
+                if (args.size() == 1)
+                    breakpoints.clear();
+                update_breakpoints();
+                args = { "step" };
+            }},
+            { "breakpoints", [&] () {
+                for (const auto& [id, entry]: breakpoints.entries()) {
+                    std::string kinds;
+                    if (entry.kinds & Breakpoints::BREAK)
+                        kinds += 'x';
+                    if (entry.kinds & Breakpoints::READ)
+                        kinds += 'r';
+                    if (entry.kinds & Breakpoints::WRITE)
+                        kinds += 'w';
+                    std::cout << std::format("{}: {:04x}-{:04x} {}\n", id, entry.first, entry.last, kinds);
+                }
+                args = { "step" };
             }},
             { "stop", [&] () {
                 if (args.size() != 1) {
@@ -101,9 +307,25 @@ int main(int argc, const char* argv[]) {
                     return;
                 }
                 args = { "step" };
-                computer.stop();
+                history.stop();
+                input_log.record_stop(computer.get_state().cycle);
             }},
             { "run", [&] () {
+                if (args.size() >= 3 && args[1] == "until") {
+                    std::string expression;
+                    for (size_t i = 2; i < args.size(); ++i)
+                        expression += args[i] + ' ';
+                    try {
+                        set_until(std::make_shared<StopCondition>(Condition(expression), machine.memory));
+                    } catch (const std::invalid_argument& e) {
+                        std::cerr << "Invalid condition: " << e.what() << '\n';
+                        args = { "step" };
+                        return;
+                    }
+                    args = { "stop" };
+                    history.run();
+                    return;
+                }
                 double freq = std::numeric_limits<double>::infinity();
                 if (args.size() == 2) {
                     try {
@@ -118,14 +340,25 @@ int main(int argc, const char* argv[]) {
                     return;
                 }
                 args = { "stop" };
-                computer.run(freq);
+                set_until(nullptr);
+                history.run(freq);
             }},
             { "help", [&] () {
                 std::cout << "run: Run the CPU as quickly as possible (with no timing overhead).\n";
                 std::cout << "run <f>: Try to run the CPU at a fixed frequency 'f' (Hz).\n";
-                std::cout << "step: Execute one CPU cycle.\n";
+                std::cout << "step: Execute one CPU cycle (waking the CPU if it is halted).\n";
                 std::cout << "step <n>: Execute 'n' CPU cycles as quickly as possible.\n";
+                std::cout << "run until <e>: Run the CPU as quickly as possible until expression 'e' is true before an instruction,\n";
+                std::cout << "    e.g. \"run until pc == 0x0310 && gb > 4\" (see the README for the syntax).\n";
                 std::cout << "stop: Stop the CPU if it's running.\n";
+                std::cout << "back: Go back one CPU cycle.\n";
+                std::cout << "back <n>: Go back 'n' CPU cycles.\n";
+                std::cout << "rcontinue <a>: Go back to the last time the CPU was about to execute the instruction at address 'a'.\n";
+                std::cout << "rcontinue <e>: Go back to the last instruction boundary where expression 'e' was true, e.g. \"rcontinue gb == 3\".\n";
+                std::cout << "break <a>: Stop the CPU before it executes the instruction at address 'a'.\n";
+                std::cout << "watch <a> [n] [r|w|rw]: Stop the CPU after it reads and/or writes (default: writes) any of the 'n' (default: 1) bytes from address 'a'.\n";
+                std::cout << "delete [i]: Remove breakpoint or watchpoint 'i' (default: all of them).\n";
+                std::cout << "breakpoints: List the breakpoints and watchpoints.\n";
                 std::cout << "exit: Close the emulator.\n";
                 args = { "step" };
             }},
@@ -158,16 +391,12 @@ int main(int argc, const char* argv[]) {
 
     sf::RenderWindow window(sf::VideoMode(sf::Vector2u(1280 + 600, 800)), "", sf::Style::Default);
     window.setVerticalSyncEnabled(true);
-    sf::Font font;
-    if (!font.openFromFile("./fonts/Hack-Regular.ttf")) {
-        std::cerr << "Failed to open font.\n";
-        return 1;
-    }
     sf::Text text(font);
     text.setCharacterSize(18);
     text.setPosition({ 1280.0f, 0.0f });
 
     while (window.isOpen()) {
+        EventTrace::Span frame_span("frame", "gui");
         if (exit.load(std::memory_order_relaxed))
             goto closed;
 
@@ -175,6 +404,12 @@ int main(int argc, const char* argv[]) {
             if (event->is<sf::Event::KeyPressed>()) {
                 if (event->getIf<sf::Event::KeyPressed>()->code == sf::Keyboard::Key::Escape)
                     goto closed;
+            } else if (event->is<sf::Event::TextEntered>()) {
+                const char32_t unicode = event->getIf<sf::Event::TextEntered>()->unicode;
+                if (unicode < 0x80) {
+                    machine.keyboard().push(unicode);
+                    computer.wake();
+                }
             } else if (event->is<sf::Event::Closed>()) {
                 goto closed;
             } else if (event->is<sf::Event::Resized>()) {
@@ -184,11 +419,35 @@ int main(int argc, const char* argv[]) {
             }
         }
 
-        text.setString(computer.debug_state());
+        for (const Breakpoints::Hit& hit: breakpoints.take_hits()) {
+            if (hit.kind == Breakpoints::BREAK)
+                std::cout << std::format("\nBreakpoint hit at {:04x} (cycle {}).\n", hit.pc, hit.cycle);
+            else
+                std::cout << std::format("\nWatchpoint hit: {} {:04x} at {:04x} (cycle {}).\n",
+                    hit.kind == Breakpoints::READ ? "read" : "write", hit.address, hit.pc, hit.cycle);
+        }
+
+        {
+            std::lock_guard lock(until_mutex);
+            if (until && until->met() && !until_reported) {
+                std::cout << std::format("\nCondition met at {:04x} (cycle {}).\n", computer.get_state().pc, computer.get_state().cycle);
+                until_reported = true;
+            }
+        }
+
+        // the renderer's time for the last frame against the display's frame time
+        const ScreenRenderer::FrameTime& frame = screen_renderer.get_last_frame();
+        text.setString(computer.debug_state() + std::format("\nframe: {:.2f}ms, {:.0f}% of budget\nover:  {} of {}\n",
+            frame.total() * 1e3, 100 * frame.total() / ScreenRenderer::FRAME_BUDGET,
+            screen_renderer.get_frames_over_budget(), screen_renderer.get_frames()));
 
         window.clear();
         window.draw(text);
-        screen_renderer.draw(window);
+        {
+            EventTrace::Span span("draw screen", "gui");
+            screen_renderer.draw(window);
+        }
+        EventTrace::Span span("display", "gui");
         window.display();
     }
 
@@ -196,4 +455,26 @@ closed:
     window.close();
     exit.store(true, std::memory_order_relaxed);
     input_thread.join();
+
+    if (record_file.has_value()) {
+        history.stop();
+        input_log.record_stop(computer.get_state().cycle);
+        input_log.write(*record_file);
+    }
+
+    if (timeline_file.has_value()) {
+        // joins the recorder too, which could restart the core or wait on its lock
+        history.stop();
+        if (call_timeline.has_value()) {
+            computer.detach_probe(&*call_timeline);
+            call_timeline->finish();
+        }
+        timeline.stop();
+        try {
+            timeline.write(*timeline_file);
+        } catch (const std::runtime_error& e) {
+            std::cerr << e.what() << '\n';
+            return EIO;
+        }
+    }
 }
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "../../inc/frontend/screen_renderer.hpp"
-#include <SFML/Graphics/RenderWindow.hpp>
+#include <SFML/Graphics/RenderTarget.hpp>
+
+#include <chrono>
 
 void ScreenRenderer::draw_char(unsigned int x, unsigned int y, const uint8_t* bitmap, const sf::Color& foreground, const sf::Color& background) {
     for (unsigned int y2 = 0; y2 < CHAR_HEIGHT; ++y2) {
@@ -10,15 +12,19 @@ void ScreenRenderer::draw_char(unsigned int x, unsigned int y, const uint8_t* bi
     }
 }
 
-void ScreenRenderer::draw_screen() {
+void ScreenRenderer::read_screen() {
     auto& memory = screen->memory();
+    for (size_t i = 0; i < cells.size(); ++i)
+        cells[i] = memory.read(i).value;
+}
 
+void ScreenRenderer::draw_screen() {
     for (unsigned int y = 0; y < screen->height; ++y) {
         for (unsigned int x = 0; x < screen->width; ++x) {
-            const size_t memory_index = (y * screen->width + x) * 2;
-            const uint8_t* bitmap = FONT + memory.read(memory_index).value * CHAR_HEIGHT;
-            const uint8_t color_index = memory.read(memory_index + 1).value;
-            
+            const size_t cell_index = (y * screen->width + x) * 2;
+            const uint8_t* bitmap = FONT + cells[cell_index] * CHAR_HEIGHT;
+            const uint8_t color_index = cells[cell_index + 1];
+
             draw_char(x, y, bitmap, COLOR[color_index >> 4], COLOR[color_index & 0x0F]);
         }
     }
@@ -26,6 +32,7 @@ void ScreenRenderer::draw_screen() {
 
 ScreenRenderer::ScreenRenderer(Screen* screen, unsigned int offset_x, unsigned int offset_y, float scale) :
     screen(screen),
+    cells(screen->width * screen->height * 2),
     image({ screen->width * 8, screen->height * CHAR_HEIGHT }),
     texture(image),
     sprite(texture)
@@ -34,8 +41,36 @@ ScreenRenderer::ScreenRenderer(Screen* screen, unsigned int offset_x, unsigned i
     sprite.setScale({ (float)scale, (float)scale });
 }
 
-void ScreenRenderer::draw(sf::RenderWindow& window) {
+void ScreenRenderer::draw(sf::RenderTarget& target) {
+    using clock = std::chrono::steady_clock;
+    const auto seconds = [] (clock::time_point begin, clock::time_point end) {
+        return std::chrono::duration<double>(end - begin).count();
+    };
+
+    const auto begin = clock::now();
+    read_screen();
+    const auto read = clock::now();
     draw_screen();
+    const auto expand = clock::now();
     texture.update(image);
-    window.draw(sprite);
-}
\ No newline at end of file
+    const auto upload = clock::now();
+    target.draw(sprite);
+    const auto end = clock::now();
+
+    last_frame = { seconds(begin, read), seconds(read, expand), seconds(expand, upload), seconds(upload, end) };
+    ++frames;
+    if (last_frame.total() > FRAME_BUDGET)
+        ++frames_over_budget;
+}
+
+const ScreenRenderer::FrameTime& ScreenRenderer::get_last_frame() const {
+    return last_frame;
+}
+
+uint64_t ScreenRenderer::get_frames() const {
+    return frames;
+}
+
+uint64_t ScreenRenderer::get_frames_over_budget() const {
+    return frames_over_budget;
+}
@@ -0,0 +1,283 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../../inc/emulator/computer.hpp"
+#include "../../inc/emulator/machine.hpp"
+#include "../../inc/utils/arg_parse.hpp"
+
+using namespace std::chrono_literals;
+
+// Batch runner: forks worker processes that each run a share of the jobs and hand results back to
+// the parent through lock-free rings in a shared memory region. Crashed workers are restarted and
+// resume their remaining jobs.
+
+static constexpr size_t RING_SIZE = 256;
+
+enum class JobStatus : uint32_t {
+    DONE,
+    FAULT, // the guest raised an exception (e.g. illegal instruction)
+    CRASH, // the worker process died while running the job
+};
+
+struct JobResult {
+    Computer::State state;
+    uint64_t screen_hash;
+    uint64_t job;
+    JobStatus status;
+};
+
+// Single-producer (worker) single-consumer (parent) ring.
+struct ResultRing {
+    std::atomic_uint64_t head;
+    std::atomic_uint64_t tail;
+    JobResult slots[RING_SIZE];
+
+    bool try_push(const JobResult& result) {
+        const uint64_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) == RING_SIZE)
+            return false;
+        slots[h % RING_SIZE] = result;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_pop(JobResult& result) {
+        const uint64_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire))
+            return false;
+        result = slots[t % RING_SIZE];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+struct WorkerShared {
+    std::atomic_uint64_t next; // index (within this worker's share) of the job being run or to run next
+    ResultRing ring;
+};
+
+static_assert(std::atomic_uint64_t::is_always_lock_free);
+
+struct Job {
+    std::string image;
+    uint64_t cycles;
+};
+
+uint64_t fnv1a(const MemoryDevice& memory, size_t size) {
+    uint64_t hash = 0xCBF29CE484222325;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= memory.read(i).value;
+        hash *= 0x100000001B3;
+    }
+    return hash;
+}
+
+JobResult run_job(const Job& job, const MemoryMap& image, uint64_t index) {
+    JobResult result {};
+    result.job = index;
+
+    Machine machine;
+    Computer computer;
+    computer.attach_memory(machine.memory);
+    computer.debug_init();
+    machine.load(image);
+    computer.reset();
+
+    try {
+        computer.step_sync(job.cycles);
+        result.status = JobStatus::DONE;
+    } catch (const std::exception&) {
+        result.status = JobStatus::FAULT;
+    }
+
+    result.state = computer.get_state();
+    result.screen_hash = fnv1a(machine.screen.memory(), machine.screen.width * machine.screen.height * 2);
+    return result;
+}
+
+[[noreturn]] void worker_main(size_t worker, size_t workers, const std::vector<Job>& jobs, const std::map<std::string, MemoryMap>& images, WorkerShared& shared) {
+    for (;;) {
+        const uint64_t k = shared.next.load(std::memory_order_relaxed);
+        const uint64_t index = worker + k * workers;
+        if (index >= jobs.size())
+            _exit(0);
+
+        const JobResult result = run_job(jobs[index], images.at(jobs[index].image), index);
+        while (!shared.ring.try_push(result))
+            std::this_thread::sleep_for(100us);
+        shared.next.store(k + 1, std::memory_order_relaxed);
+    }
+}
+
+std::vector<Job> read_jobs(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file) {
+        std::cerr << "IO error.\n";
+        std::exit(EIO);
+    }
+    std::vector<Job> jobs;
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream s(line);
+        Job job;
+        if (!(s >> job.image))
+            continue;
+        if (!(s >> job.cycles)) {
+            std::cerr << "Invalid job: " << line << '\n';
+            std::exit(EINVAL);
+        }
+        jobs.emplace_back(std::move(job));
+    }
+    return jobs;
+}
+
+int main(int argc, const char* argv[]) {
+    ArgParse args(argc, argv);
+
+    if (auto error = args.get_error()) {
+        std::cerr << "Error parsing arguments: " << *error << std::endl;
+        return EINVAL;
+    }
+
+    auto workers_str = args.take_option("--workers");
+    auto job_file = args.take_normal();
+
+    if (args.has_remaining() || !job_file.has_value()) {
+        std::cerr << "Usage: " << argv[0] << " <job list> [--workers n]" << std::endl;
+        std::cerr << "Each line of the job list is \"<program binary> <cycles>\"." << std::endl;
+        return EINVAL;
+    }
+
+    const std::optional<uint64_t> workers_arg = workers_str.has_value() ? ArgParse::parse_number(*workers_str) : std::thread::hardware_concurrency();
+    if (!workers_arg.has_value()) {
+        std::cerr << "Invalid worker count: " << *workers_str << '\n';
+        return EINVAL;
+    }
+
+    const std::vector<Job> jobs = read_jobs(*job_file);
+    const size_t workers = std::max<size_t>(1, std::min<size_t>(jobs.size(), *workers_arg));
+
+    // load every image once; workers inherit them through fork
+    std::map<std::string, MemoryMap> images;
+    for (const Job& job: jobs) {
+        if (images.contains(job.image))
+            continue;
+        try {
+            images[job.image].read(job.image);
+        } catch (const std::runtime_error& e) {
+            std::cerr << e.what() << '\n';
+            return EIO;
+        }
+    }
+
+    const size_t shared_size = sizeof(WorkerShared) * workers;
+    const int fd = memfd_create("emulator_batch", 0);
+    if (fd < 0 || ftruncate(fd, shared_size) != 0) {
+        std::cerr << "Failed to create shared memory: " << std::strerror(errno) << '\n';
+        return EIO;
+    }
+    void* region = mmap(nullptr, shared_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (region == MAP_FAILED) {
+        std::cerr << "Failed to map shared memory: " << std::strerror(errno) << '\n';
+        return EIO;
+    }
+    WorkerShared* shared = static_cast<WorkerShared*>(region);
+    for (size_t i = 0; i < workers; ++i)
+        new (&shared[i]) WorkerShared {};
+
+    std::vector<pid_t> pids(workers, -1);
+    auto spawn = [&] (size_t worker) {
+        const pid_t pid = fork();
+        if (pid < 0) {
+            std::cerr << "Failed to fork: " << std::strerror(errno) << '\n';
+            std::exit(EIO);
+        }
+        if (pid == 0)
+            worker_main(worker, workers, jobs, images, shared[worker]);
+        pids[worker] = pid;
+    };
+    for (size_t i = 0; i < workers; ++i)
+        spawn(i);
+
+    std::vector<JobResult> results(jobs.size());
+    std::vector<bool> have(jobs.size(), false);
+    size_t received = 0;
+    size_t restarts = 0;
+
+    auto drain = [&] (size_t worker) {
+        bool any = false;
+        for (JobResult result; shared[worker].ring.try_pop(result); any = true) {
+            results[result.job] = result;
+            have[result.job] = true;
+            ++received;
+        }
+        return any;
+    };
+
+    while (received != jobs.size()) {
+        bool progress = false;
+        for (size_t i = 0; i < workers; ++i)
+            progress |= drain(i);
+
+        int status;
+        const pid_t pid = waitpid(-1, &status, WNOHANG);
+        if (pid > 0) {
+            const size_t worker = std::find(pids.begin(), pids.end(), pid) - pids.begin();
+            pids[worker] = -1;
+            progress = true;
+            drain(worker);
+
+            const uint64_t k = shared[worker].next.load(std::memory_order_relaxed);
+            const uint64_t index = worker + k * workers;
+            if (index < jobs.size()) {
+                // the worker died mid-job (or right after handing its result over): record it and carry on with the next one
+                if (!have[index]) {
+                    results[index] = JobResult {};
+                    results[index].job = index;
+                    results[index].status = JobStatus::CRASH;
+                    have[index] = true;
+                    ++received;
+                }
+                shared[worker].next.store(k + 1, std::memory_order_relaxed);
+                if (index + workers < jobs.size()) {
+                    spawn(worker);
+                    ++restarts;
+                }
+            }
+        }
+
+        if (!progress)
+            std::this_thread::sleep_for(1ms);
+    }
+
+    for (pid_t pid: pids) {
+        if (pid > 0)
+            waitpid(pid, nullptr, 0);
+    }
+    munmap(region, shared_size);
+
+    static const char* STATUS_NAMES[] { "done", "fault", "crash" };
+    for (const JobResult& result: results) {
+        std::cout << std::format("job {}: {} cycle={} pc={:04x} screen={:016x}\n",
+            result.job, STATUS_NAMES[(int)result.status], result.state.cycle, result.state.pc, result.screen_hash);
+    }
+    if (restarts != 0)
+        std::cout << "restarted workers: " << restarts << '\n';
+}
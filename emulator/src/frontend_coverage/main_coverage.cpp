@@ -0,0 +1,48 @@
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../../inc/emulator/coverage.hpp"
+#include "../../inc/utils/arg_parse.hpp"
+
+// Coverage report frontend: merges the coverage maps written by the headless emulator's --coverage
+// and prints the coverage of the program they were recorded with.
+
+int main(int argc, const char* argv[]) {
+    ArgParse args(argc, argv);
+
+    if (auto error = args.get_error()) {
+        std::cerr << "Error parsing arguments: " << *error << std::endl;
+        return EINVAL;
+    }
+
+    auto symbols_file = args.take_option("--symbols");
+    auto program_file = args.take_normal();
+    std::vector<std::string> coverage_files;
+    while (auto coverage_file = args.take_normal())
+        coverage_files.push_back(*coverage_file);
+
+    if (args.has_remaining() || !program_file.has_value() || coverage_files.empty()) {
+        std::cerr << "Usage: " << argv[0] << " <program binary> <coverage map>... [--symbols symbol file]" << std::endl;
+        return EINVAL;
+    }
+
+    try {
+        CoverageMap coverage;
+        for (const std::string& coverage_file: coverage_files)
+            coverage.read(coverage_file);
+
+        SymbolTable symbols;
+        if (symbols_file.has_value())
+            symbols.read(*symbols_file);
+
+        MemoryMap program;
+        program.read(*program_file);
+
+        coverage.report(std::cout, program, symbols);
+    } catch (const std::runtime_error& e) {
+        std::cerr << e.what() << std::endl;
+        return EIO;
+    }
+}
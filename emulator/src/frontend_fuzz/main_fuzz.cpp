@@ -0,0 +1,122 @@
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "../../inc/emulator/computer.hpp"
+#include "../../inc/emulator/fuzzer.hpp"
+#include "../../inc/emulator/machine.hpp"
+#include "../../inc/utils/arg_parse.hpp"
+
+using namespace std::chrono_literals;
+
+// Fuzzer frontend: runs a program to the start pc, then feeds mutated inputs to the routine there,
+// printing progress every second and the distinct crashes at the end.
+
+int main(int argc, const char* argv[]) {
+    ArgParse args(argc, argv);
+
+    if (auto error = args.get_error()) {
+        std::cerr << "Error parsing arguments: " << *error << std::endl;
+        return EINVAL;
+    }
+
+    auto start_str = args.take_option("--start");
+    auto input_str = args.take_option("--input");
+    auto size_str = args.take_option("--size");
+    auto budget_str = args.take_option("--budget");
+    auto start_budget_str = args.take_option("--start-budget");
+    auto runs_str = args.take_option("--runs");
+    auto seed_str = args.take_option("--seed");
+    auto crash_dir = args.take_option("--crashes");
+    auto program_file = args.take_normal();
+
+    if (args.has_remaining() || !program_file.has_value() || !start_str.has_value() || !input_str.has_value() || !size_str.has_value()) {
+        std::cerr << "Usage: " << argv[0] << " <program binary> --start pc --input address --size n [--budget cycles] [--start-budget cycles] [--runs n] [--seed n] [--crashes directory]" << std::endl;
+        return EINVAL;
+    }
+
+    const std::optional<uint64_t> start = ArgParse::parse_number(*start_str);
+    const std::optional<uint64_t> input_address = ArgParse::parse_number(*input_str);
+    const std::optional<uint64_t> input_size = ArgParse::parse_number(*size_str);
+    if (!start.has_value() || !input_address.has_value() || !input_size.has_value() || *start > 0xFFFF || *input_address > 0xFFFF || *input_size > 0xFFFF) {
+        std::cerr << "Start pc, input address and size must be numbers up to 0xffff." << std::endl;
+        return EINVAL;
+    }
+    const std::optional<uint64_t> budget = budget_str.has_value() ? ArgParse::parse_number(*budget_str) : 10000;
+    const std::optional<uint64_t> start_budget = start_budget_str.has_value() ? ArgParse::parse_number(*start_budget_str) : 10000000;
+    const std::optional<uint64_t> seed = seed_str.has_value() ? ArgParse::parse_number(*seed_str) : 0;
+    const std::optional<uint64_t> runs_arg = runs_str.has_value() ? ArgParse::parse_number(*runs_str) : 1000000;
+    if (!budget.has_value() || !start_budget.has_value() || !seed.has_value() || !runs_arg.has_value()) {
+        std::cerr << "Budgets, seed and run count must be numbers." << std::endl;
+        return EINVAL;
+    }
+
+    Fuzzer::Config config;
+    config.start = *start;
+    config.input_address = *input_address;
+    config.input_size = *input_size;
+    config.budget = *budget;
+    config.start_budget = *start_budget;
+    config.seed = *seed;
+    const uint64_t runs = *runs_arg;
+
+    Machine machine;
+    Computer computer;
+    computer.attach_memory(machine.memory);
+    computer.debug_init();
+
+    MemoryMap map;
+    try {
+        map.read(*program_file);
+    } catch (const std::runtime_error& e) {
+        std::cerr << e.what() << std::endl;
+        return EIO;
+    }
+    machine.load(map);
+    computer.reset();
+
+    Fuzzer fuzzer(machine, computer, config);
+    try {
+        fuzzer.prepare();
+    } catch (const std::runtime_error& e) {
+        std::cerr << e.what() << std::endl;
+        return EINVAL;
+    }
+
+    const auto begin = std::chrono::steady_clock::now();
+    auto report = begin;
+    auto print_stats = [&] {
+        const Fuzzer::Stats& stats = fuzzer.stats();
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        std::cout << std::format("runs {} ({:.0f}/s), edges {}, corpus {}, crashes {} ({} distinct)\n",
+            stats.runs, stats.runs / seconds, stats.edges, fuzzer.corpus().size(), stats.crashes, fuzzer.crashes().size());
+    };
+
+    fuzzer.run({});
+    for (uint64_t i = 1; i < runs; ++i) {
+        fuzzer.fuzz();
+        if ((i & 0xFFF) == 0 && std::chrono::steady_clock::now() - report >= 1s) {
+            report = std::chrono::steady_clock::now();
+            print_stats();
+        }
+    }
+    print_stats();
+
+    size_t n = 0;
+    for (const auto& [key, crash]: fuzzer.crashes()) {
+        std::cout << std::format("crash at pc={:04x} cycle={}: {}\n", crash.state.pc, crash.state.cycle, crash.what);
+        if (crash_dir.has_value()) {
+            std::filesystem::create_directories(*crash_dir);
+            const std::filesystem::path path = std::filesystem::path(*crash_dir) / std::format("crash-{:04x}-{}.bin", crash.state.pc, n++);
+            std::ofstream file(path, std::ios::binary);
+            file.write(reinterpret_cast<const char*>(crash.input.data()), crash.input.size());
+            std::cout << "  input saved to " << path.string() << '\n';
+        }
+    }
+}
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <atomic>
 #include <cstdint>
 #include <fstream>
@@ -5,6 +6,9 @@
 #include <initializer_list>
 #include <iostream>
 #include <limits>
+#include <memory>
+#include <optional>
+#include <string>
 #include <thread>
 
 #include <unistd.h>
@@ -12,8 +16,17 @@
 #include <utility>
 #include <vector>
 
-#include "../../inc/emulator/computer.hpp"
-#include "../../inc/emulator/screen.hpp"
+#include "../../inc/emulator/call_profiler.hpp"
+#include "../../inc/emulator/call_timeline.hpp"
+#include "../../inc/emulator/cluster.hpp"
+#include "../../inc/emulator/condition.hpp"
+#include "../../inc/emulator/coverage.hpp"
+#include "../../inc/emulator/event_trace.hpp"
+#include "../../inc/emulator/host_counters.hpp"
+#include "../../inc/emulator/machine.hpp"
+#include "../../inc/emulator/metrics_server.hpp"
+#include "../../inc/emulator/profiler.hpp"
+#include "../../inc/emulator/tracer.hpp"
 #include "../../inc/utils/split.hpp"
 #include "../../inc/utils/arg_parse.hpp"
 
@@ -68,6 +81,22 @@ static const char *TERM_BG_COLORS[] {
     "100"  // F: DARK GRAY
 };
 
+// parse "a..b" (inclusive)
+std::optional<std::pair<uint64_t, uint64_t>> parse_range(const std::string& str) {
+    const size_t dots = str.find("..");
+    if (dots == std::string::npos)
+        return std::nullopt;
+    try {
+        const uint64_t first = std::stoull(str.substr(0, dots), nullptr, 0);
+        const uint64_t last = std::stoull(str.substr(dots + 2), nullptr, 0);
+        if (first > last)
+            return std::nullopt;
+        return std::make_pair(first, last);
+    } catch (const std::exception&) {
+        return std::nullopt;
+    }
+}
+
 void print_color_escape_sequence(const uint8_t color_index) {
     unsigned char foreground = color_index >> 4;
     unsigned char background = color_index & 0x0F;
@@ -99,6 +128,48 @@ void print_screen(Screen &screen) {
     std::cout << "\033[0m" << std::endl;  // reset formatting
 }
 
+struct GuestProgress {
+    uint64_t cycles;
+    uint64_t instructions;
+};
+
+// cycles and instructions of all cores, the instructions counted by the cores when built with
+// statistics and otherwise five cycles each (which also counts cycles spent halted)
+GuestProgress guest_progress(Cluster& cluster) {
+    GuestProgress progress {};
+    for (Computer* core: cluster.cores()) {
+        progress.cycles += core->get_state().cycle;
+        if constexpr (Computer::STATISTICS) {
+            const Computer::Statistics statistics = core->get_statistics();
+            for (const uint64_t count: statistics.formats)
+                progress.instructions += count;
+        }
+    }
+    if constexpr (!Computer::STATISTICS)
+        progress.instructions = progress.cycles / 5;
+    return progress;
+}
+
+bool stopped_by_probe(Cluster& cluster) {
+    for (Computer* core: cluster.cores()) {
+        if (core->stopped_by_probe())
+            return true;
+    }
+    return false;
+}
+
+// Run until a probe stops a core or every core is halted until an event (--until without a limit).
+void run_until_stopped(Cluster& cluster, uint64_t quantum, Cluster::Sync sync) {
+    static constexpr uint64_t CHUNK = 1 << 24;
+    for (uint64_t cycles = guest_progress(cluster).cycles;;) {
+        cluster.step_sync(CHUNK, quantum, sync);
+        const uint64_t now = guest_progress(cluster).cycles;
+        if (stopped_by_probe(cluster) || now == cycles)
+            return;
+        cycles = now;
+    }
+}
+
 int main(int argc, const char* argv[]) {
     ArgParse args(argc, argv);
 
@@ -108,40 +179,361 @@ int main(int argc, const char* argv[]) {
     }
 
     auto step_limit_str = args.take_option("--step-limit");
+    auto cores_str = args.take_option("--cores");
+    auto quantum_str = args.take_option("--quantum");
+    auto sync_str = args.take_option("--sync");
+    auto resume_file = args.take_option("--resume");
+    auto snapshot_file = args.take_option("--snapshot");
+    auto replay_file = args.take_option("--replay");
+    auto until_str = args.take_option("--until");
+    auto trace_file = args.take_option("--trace");
+    auto trace_pcs_str = args.take_option("--trace-pcs");
+    auto trace_cycles_str = args.take_option("--trace-cycles");
+    auto profile_file = args.take_option("--profile");
+    auto symbols_file = args.take_option("--symbols");
+    auto callgraph_file = args.take_option("--callgraph");
+    auto coverage_file = args.take_option("--coverage");
+    auto perf_str = args.take_option("--perf");
+    auto timeline_file = args.take_option("--timeline");
+    auto metrics_socket = args.take_option("--metrics");
     auto program_file = args.take_normal();
 
     if (args.has_remaining() || !program_file.has_value()) {
-        std::cerr << "Usage: " << argv[0] << " <program binary> [--step-limit n]" << std::endl;
+        std::cerr << "Usage: " << argv[0] << " <program binary> [--step-limit n] [--cores n] [--quantum n] [--sync parallel|deterministic] [--resume snapshot] [--snapshot snapshot] [--replay input log] [--until expression] [--trace file] [--trace-pcs a..b] [--trace-cycles a..b] [--profile report] [--callgraph callgrind file] [--coverage coverage map] [--perf interval] [--timeline trace file] [--metrics socket] [--symbols symbol file]" << std::endl;
         return EINVAL;
     }
 
-    Computer computer;
+    Cluster::Sync sync = Cluster::Sync::PARALLEL;
+    if (sync_str.has_value()) {
+        if (*sync_str == "deterministic")
+            sync = Cluster::Sync::DETERMINISTIC;
+        else if (*sync_str != "parallel") {
+            std::cerr << "Invalid sync mode: " << *sync_str << std::endl;
+            return EINVAL;
+        }
+    }
+
+    const std::optional<uint64_t> cores_arg = cores_str.has_value() ? ArgParse::parse_number(*cores_str) : 1;
+    const std::optional<uint64_t> quantum_arg = quantum_str.has_value() ? ArgParse::parse_number(*quantum_str) : 1000;
+    if (!cores_arg.has_value() || !quantum_arg.has_value() || *cores_arg == 0 || *quantum_arg == 0) {
+        std::cerr << "Core count and quantum must be nonzero numbers." << std::endl;
+        return EINVAL;
+    }
+    const size_t cores = *cores_arg;
+    const uint64_t quantum = *quantum_arg;
 
-    Screen screen(80, 50);
-    const size_t screen_memory_size = screen.memory().size();
-    
-    MemoryDevicePointer memory_interface = new InterfaceDevice(MemoryDevice::Access::READ_WRITE);
-    // bootloader rom 0x0000 to 0x00FF
-    memory_interface.get<InterfaceDevice>().add_device(0x0000, new BufferMemoryDevice(0x0100, MemoryDevice::Access::READ_ONLY));
-    // main memory 0x0100 to before start of screen character memory
-    memory_interface.get<InterfaceDevice>().add_device(0x0100, new BufferMemoryDevice(0xFF00 - screen_memory_size, MemoryDevice::Access::READ_WRITE));
-    // map screen character memory from end of main memory to end of address space
-    memory_interface.get<InterfaceDevice>().add_device(0x10000 - screen_memory_size, &screen.memory());
+    std::optional<uint64_t> step_limit = 10000;
+    if (step_limit_str.has_value()) {
+        step_limit = ArgParse::parse_number(*step_limit_str);
+        if (!step_limit.has_value()) {
+            std::cerr << "Invalid step limit: " << *step_limit_str << std::endl;
+            return EINVAL;
+        }
+    }
 
-    computer.attach_memory(memory_interface);
-    computer.debug_init();
+    // host counters every interval guest cycles, or only for the whole run with 0
+    std::optional<uint64_t> perf_interval;
+    if (perf_str.has_value()) {
+        perf_interval = ArgParse::parse_number(*perf_str);
+        if (!perf_interval.has_value()) {
+            std::cerr << "Invalid perf interval: " << *perf_str << std::endl;
+            return EINVAL;
+        }
+        if (*perf_interval != 0)
+            perf_interval = (*perf_interval + quantum - 1) / quantum * quantum;
+    }
+
+    std::optional<Condition> until;
+    if (until_str.has_value()) {
+        try {
+            until.emplace(*until_str);
+        } catch (const std::invalid_argument& e) {
+            std::cerr << "Invalid condition: " << e.what() << std::endl;
+            return EINVAL;
+        }
+    }
+
+    Tracer::Filter trace_filter;
+    if (trace_pcs_str.has_value()) {
+        const auto range = parse_range(*trace_pcs_str);
+        if (!range.has_value() || range->second > 0xFFFF) {
+            std::cerr << "Invalid pc range: " << *trace_pcs_str << std::endl;
+            return EINVAL;
+        }
+        trace_filter.first_pc = range->first;
+        trace_filter.last_pc = range->second;
+    }
+    if (trace_cycles_str.has_value()) {
+        const auto range = parse_range(*trace_cycles_str);
+        if (!range.has_value()) {
+            std::cerr << "Invalid cycle range: " << *trace_cycles_str << std::endl;
+            return EINVAL;
+        }
+        trace_filter.begin_cycle = range->first;
+        trace_filter.end_cycle = range->second == std::numeric_limits<uint64_t>::max() ? range->second : range->second + 1;
+    }
+
+    SymbolTable symbols;
+    if (symbols_file.has_value()) {
+        try {
+            symbols.read(*symbols_file);
+        } catch (const std::runtime_error& e) {
+            std::cerr << e.what() << std::endl;
+            return EIO;
+        }
+    }
+
+    Machine machine;
+    Cluster cluster(cores, machine.memory);
+    cluster.debug_init();
 
     MemoryMap map;
-    map.read(argv[1]);
-    memory_interface->debug_write(map);
+    try {
+        map.read(*program_file);
+    } catch (const std::runtime_error& e) {
+        std::cerr << e.what() << std::endl;
+        return EIO;
+    }
+    machine.load(map);
+
+    cluster.reset();
+    if (resume_file.has_value()) {
+        auto snapshot = std::make_shared<Snapshot>();
+        try {
+            snapshot->read(*resume_file);
+        } catch (const std::runtime_error& e) {
+            std::cerr << e.what() << std::endl;
+            return EIO;
+        }
+        try {
+            machine.restore(snapshot, cluster.cores());
+        } catch (const std::invalid_argument& e) {
+            std::cerr << e.what() << std::endl;
+            return EINVAL;
+        }
+    }
+
+    // replay a recorded session (from reset) up to where the recording stopped
+    InputLog input_log;
+    if (replay_file.has_value()) {
+        if (cores != 1 || resume_file.has_value()) {
+            std::cerr << "Replay needs a single core starting from reset." << std::endl;
+            return EINVAL;
+        }
+        try {
+            input_log.read(*replay_file);
+        } catch (const std::runtime_error& e) {
+            std::cerr << e.what() << std::endl;
+            return EIO;
+        }
+        cluster.core(0).attach_input_log(&input_log);
+    }
+
+    // stop as soon as the condition holds on any core (every core checks its own state)
+    std::vector<std::unique_ptr<StopCondition>> stop_conditions;
+    if (until.has_value()) {
+        for (Computer* core: cluster.cores()) {
+            stop_conditions.push_back(std::make_unique<StopCondition>(*until, machine.memory));
+            core->attach_probe(stop_conditions.back().get());
+        }
+    }
+
+    // one trace per core: <file> for a single core, <file>.<i> otherwise
+    std::vector<std::unique_ptr<Tracer>> tracers;
+    if (trace_file.has_value()) {
+        for (size_t i = 0; i < cores; ++i) {
+            const std::string filename = cores == 1 ? *trace_file : *trace_file + "." + std::to_string(i);
+            tracers.push_back(std::make_unique<Tracer>(cluster.core(i), filename, trace_filter));
+        }
+    }
+
+    std::vector<std::unique_ptr<Profiler>> profilers;
+    if (profile_file.has_value()) {
+        for (Computer* core: cluster.cores()) {
+            profilers.push_back(std::make_unique<Profiler>());
+            core->attach_profiler(profilers.back().get());
+        }
+    }
+
+    std::vector<std::unique_ptr<CallProfiler>> call_profilers;
+    if (callgraph_file.has_value()) {
+        for (Computer* core: cluster.cores()) {
+            call_profilers.push_back(std::make_unique<CallProfiler>());
+            core->attach_probe(call_profilers.back().get());
+        }
+    }
+
+    std::vector<std::unique_ptr<CoverageMap>> coverage_maps;
+    if (coverage_file.has_value()) {
+        for (Computer* core: cluster.cores()) {
+            coverage_maps.push_back(std::make_unique<CoverageMap>());
+            core->attach_coverage(coverage_maps.back().get());
+        }
+    }
+
+    // host spans on a timeline, and every core's guest calls when there are symbols to name them
+    // (they attach a probe, which needs the checked engine)
+    EventTrace timeline;
+    std::vector<std::unique_ptr<CallTimeline>> call_timelines;
+    if (timeline_file.has_value()) {
+        timeline.start();
+        timeline.name_thread("main");
+        for (size_t i = 0; symbols_file.has_value() && i < cores; ++i) {
+            call_timelines.push_back(std::make_unique<CallTimeline>(timeline, symbols, i));
+            cluster.core(i).attach_probe(call_timelines.back().get());
+        }
+    }
+
+    // served until the end of the run
+    std::optional<MetricsServer> metrics_server;
+    if (metrics_socket.has_value()) {
+        try {
+            metrics_server.emplace(*metrics_socket, cluster.cores(), machine.regions());
+        } catch (const std::runtime_error& e) {
+            std::cerr << e.what() << std::endl;
+            return EIO;
+        }
+    }
+
+    // none: run until the condition holds or every core halts
+    if (replay_file.has_value() && !step_limit_str.has_value())
+        step_limit = input_log.end();
+    else if (until.has_value() && !step_limit_str.has_value())
+        step_limit.reset();
+    auto run = [&] () {
+        if (step_limit.has_value())
+            cluster.step_sync(*step_limit, quantum, sync);
+        else
+            run_until_stopped(cluster, quantum, sync);
+    };
 
-    // memory_interface->debug_write<Endian::LITTLE>(0x0000, read_binary("./DEBUG_BOOTLOADER.bin"));
-    // memory_interface->debug_write<Endian::BIG>(0x0300, read_binary(*program_file));
+    // opened on this thread before the run, so they also count the cores' threads
+    std::optional<HostCounters> host_counters;
+    if (perf_interval.has_value()) {
+        host_counters.emplace();
+        if (!host_counters->available()) {
+            std::cerr << "Host counters unavailable (" << host_counters->error() << ").\n";
+            host_counters.reset();
+        }
+    }
 
-    computer.reset();
+    if (host_counters.has_value()) {
+        std::cerr << "Engine: " << (cluster.core(0).checked() ? "checked" : "unchecked") << ".\n";
+        const HostCounters::Sample begin = host_counters->read();
+        const GuestProgress begin_progress = guest_progress(cluster);
+        HostCounters::Sample last = begin;
+        GuestProgress last_progress = begin_progress;
+        if (*perf_interval != 0) {
+            for (uint64_t done = 0; !step_limit.has_value() || done < *step_limit;) {
+                const uint64_t cycles = step_limit.has_value() ? std::min(*perf_interval, *step_limit - done) : *perf_interval;
+                cluster.step_sync(cycles, quantum, sync);
+                done += cycles;
 
-    int step_limit = step_limit_str.has_value() ? std::stoi(*step_limit_str) : 10000;
-    computer.step_sync(step_limit);
+                const HostCounters::Sample sample = host_counters->read();
+                const GuestProgress progress = guest_progress(cluster);
+                // every core halted until an event that can't come
+                if (progress.cycles == last_progress.cycles)
+                    break;
+                HostCounters::report(std::cerr, last, sample, progress.instructions - last_progress.instructions, progress.cycles - last_progress.cycles);
+                last = sample;
+                last_progress = progress;
+                if (stopped_by_probe(cluster))
+                    break;
+            }
+        } else {
+            run();
+            last = host_counters->read();
+            last_progress = guest_progress(cluster);
+        }
+        std::cerr << "Whole run: ";
+        HostCounters::report(std::cerr, begin, last, last_progress.instructions - begin_progress.instructions, last_progress.cycles - begin_progress.cycles);
+    } else {
+        run();
+    }
+
+    if (until.has_value()) {
+        bool met = false;
+        for (size_t i = 0; i < stop_conditions.size(); ++i) {
+            cluster.core(i).detach_probe(stop_conditions[i].get());
+            if (stop_conditions[i]->met()) {
+                std::cerr << "Condition met on core " << i << " at cycle " << cluster.core(i).get_state().cycle << ".\n";
+                met = true;
+            }
+        }
+        if (!met)
+            std::cerr << "Condition not met.\n";
+    }
+
+    for (size_t i = 0; i < tracers.size(); ++i) {
+        tracers[i]->close();
+        std::cerr << "Traced " << tracers[i]->records() << " instructions on core " << i << ".\n";
+    }
+
+    // one report for all cores
+    if (profile_file.has_value()) {
+        for (size_t i = 0; i < profilers.size(); ++i) {
+            cluster.core(i).attach_profiler(nullptr);
+            if (i != 0)
+                profilers[0]->merge(*profilers[i]);
+        }
+        std::ofstream report(*profile_file);
+        profilers[0]->report(report, symbols);
+    }
+
+    // one callgrind file per core, like traces
+    for (size_t i = 0; i < call_profilers.size(); ++i) {
+        Computer& core = cluster.core(i);
+        core.detach_probe(call_profilers[i].get());
+        const std::string filename = cores == 1 ? *callgraph_file : *callgraph_file + "." + std::to_string(i);
+        std::ofstream callgrind(filename);
+        call_profilers[i]->write_callgrind(callgrind, symbols, core.get_state().cycle);
+        std::cerr << "Core " << i << ": ";
+        call_profilers[i]->report(std::cerr, symbols, core.get_state().cycle, 10);
+    }
+
+    // add this run's coverage to the map already in the file, if any
+    if (coverage_file.has_value()) {
+        for (size_t i = 0; i < coverage_maps.size(); ++i) {
+            cluster.core(i).attach_coverage(nullptr);
+            if (i != 0)
+                coverage_maps[0]->merge(*coverage_maps[i]);
+        }
+        try {
+            if (std::ifstream(*coverage_file))
+                coverage_maps[0]->read(*coverage_file);
+            coverage_maps[0]->write(*coverage_file);
+        } catch (const std::runtime_error& e) {
+            std::cerr << e.what() << std::endl;
+            return EIO;
+        }
+    }
+
+    if (timeline_file.has_value()) {
+        for (size_t i = 0; i < call_timelines.size(); ++i) {
+            cluster.core(i).detach_probe(call_timelines[i].get());
+            call_timelines[i]->finish();
+        }
+        timeline.stop();
+        try {
+            timeline.write(*timeline_file);
+        } catch (const std::runtime_error& e) {
+            std::cerr << e.what() << std::endl;
+            return EIO;
+        }
+        if (timeline.dropped(EventTrace::HOST) != 0)
+            std::cerr << "Timeline full, dropped " << timeline.dropped(EventTrace::HOST) << " host spans.\n";
+        if (timeline.dropped(EventTrace::GUEST) != 0)
+            std::cerr << "Timeline full, dropped " << timeline.dropped(EventTrace::GUEST) << " guest spans.\n";
+    }
+
+    if (snapshot_file.has_value()) {
+        try {
+            machine.snapshot(cluster.cores())->write(*snapshot_file);
+        } catch (const std::runtime_error& e) {
+            std::cerr << e.what() << std::endl;
+            return EIO;
+        }
+    }
 
-    print_screen(screen);
+    print_screen(machine.screen);
 }
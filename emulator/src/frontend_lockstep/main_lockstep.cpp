@@ -0,0 +1,203 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <format>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../../inc/emulator/lockstep.hpp"
+#include "../../inc/emulator/machine.hpp"
+#include "../../inc/utils/arg_parse.hpp"
+
+using namespace std::chrono_literals;
+
+// Differential tester frontend: runs a program, or random instruction streams, on two execution
+// engines in lockstep and reports the first instruction they disagree on, with a repro.
+
+static constexpr uint64_t CHUNK = 1 << 16; // instructions between progress checks
+
+// a random case: random bytes over the rom and the start of main memory
+static std::vector<uint8_t> random_bytes(uint64_t seed, size_t size) {
+    std::mt19937_64 random(seed);
+    std::vector<uint8_t> bytes(size);
+    for (uint8_t& byte: bytes)
+        byte = random();
+    return bytes;
+}
+
+static MemoryMap image(const std::vector<uint8_t>& bytes) {
+    MemoryMap map;
+    map.set_address(Machine::ROM_ADDRESS);
+    map.append(bytes.begin(), bytes.end());
+    return map;
+}
+
+// Shrink a diverging image: zero out ever smaller blocks of instruction words, keeping every change
+// that still diverges within the length. Returns the instructions it diverges after.
+static uint64_t minimize(Lockstep& lockstep, std::vector<uint8_t>& bytes, uint64_t length) {
+    auto diverges = [&] (const std::vector<uint8_t>& candidate) -> std::optional<uint64_t> {
+        lockstep.load(image(candidate));
+        const auto divergence = lockstep.run(length);
+        if (!divergence.has_value())
+            return std::nullopt;
+        return divergence->instructions;
+    };
+
+    uint64_t instructions = *diverges(bytes);
+    for (size_t block = bytes.size() / 2 & ~1; block >= 2; block /= 2) {
+        for (size_t at = 0; at < bytes.size(); at += block) {
+            std::vector<uint8_t> candidate = bytes;
+            const size_t end = std::min(at + block, bytes.size());
+            bool changed = false;
+            for (size_t i = at; i < end; ++i) {
+                changed |= candidate[i] != 0;
+                candidate[i] = 0;
+            }
+            if (!changed)
+                continue;
+            if (const auto n = diverges(candidate)) {
+                bytes = std::move(candidate);
+                instructions = *n;
+            }
+        }
+    }
+    return instructions;
+}
+
+int main(int argc, const char* argv[]) {
+    ArgParse args(argc, argv);
+
+    if (auto error = args.get_error()) {
+        std::cerr << "Error parsing arguments: " << *error << std::endl;
+        return EINVAL;
+    }
+
+    auto engines_str = args.take_option("--engines");
+    auto resume_file = args.take_option("--resume");
+    auto instructions_str = args.take_option("--instructions");
+    auto random_str = args.take_option("--random");
+    auto seed_str = args.take_option("--seed");
+    auto length_str = args.take_option("--length");
+    auto size_str = args.take_option("--size");
+    auto repro_file = args.take_option("--repro");
+    auto program_file = args.take_normal();
+
+    if (args.has_remaining() || program_file.has_value() == random_str.has_value()) {
+        std::cerr << "Usage: " << argv[0] << " <program binary> [--engines reference,test] [--resume snapshot] [--instructions n] [--repro snapshot]\n"
+                  << "       " << argv[0] << " --random cases [--engines reference,test] [--seed n] [--length instructions] [--size bytes] [--repro program binary]" << std::endl;
+        return EINVAL;
+    }
+
+    Lockstep::Engine reference = Lockstep::Engine::CHECKED;
+    Lockstep::Engine test = Lockstep::Engine::UNCHECKED;
+    if (engines_str.has_value()) {
+        const size_t comma = engines_str->find(',');
+        std::optional<Lockstep::Engine> a, b;
+        if (comma != std::string::npos) {
+            a = Lockstep::parse_engine(engines_str->substr(0, comma));
+            b = Lockstep::parse_engine(engines_str->substr(comma + 1));
+        }
+        if (!a.has_value() || !b.has_value()) {
+            std::cerr << "Invalid engines (checked, unchecked): " << *engines_str << std::endl;
+            return EINVAL;
+        }
+        reference = *a;
+        test = *b;
+    }
+    std::cout << std::format("reference {}, test {}\n", Lockstep::engine_name(reference), Lockstep::engine_name(test));
+
+    Lockstep lockstep(reference, test);
+    const auto begin = std::chrono::steady_clock::now();
+    auto report = begin;
+    uint64_t total = 0; // instructions compared, over all cases
+    auto rate = [&] {
+        return total / std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    };
+
+    if (program_file.has_value()) {
+        const uint64_t limit = instructions_str.has_value() ? std::stoull(*instructions_str) : std::numeric_limits<uint64_t>::max();
+
+        MemoryMap map;
+        map.read(*program_file);
+        lockstep.load(map);
+        if (resume_file.has_value()) {
+            auto snapshot = std::make_shared<Snapshot>();
+            try {
+                snapshot->read(*resume_file);
+            } catch (const std::runtime_error& e) {
+                std::cerr << e.what() << std::endl;
+                return EIO;
+            }
+            try {
+                lockstep.restore(snapshot);
+            } catch (const std::invalid_argument& e) {
+                std::cerr << e.what() << std::endl;
+                return EINVAL;
+            }
+        }
+
+        std::optional<Lockstep::Divergence> divergence;
+        while (!divergence.has_value() && !lockstep.finished() && lockstep.instructions() < limit) {
+            divergence = lockstep.run(std::min(CHUNK, limit - lockstep.instructions()));
+            total = lockstep.instructions();
+            if (std::chrono::steady_clock::now() - report >= 1s) {
+                report = std::chrono::steady_clock::now();
+                std::cout << std::format("instructions {} ({:.0f}/s)\n", total, rate());
+            }
+        }
+
+        if (!divergence.has_value()) {
+            std::cout << std::format("no divergence in {} instructions ({:.0f}/s){}\n", total, rate(), lockstep.finished() ? ", both stopped" : "");
+            return 0;
+        }
+        std::cout << divergence->describe();
+        // the machine at the boundary before the instruction, so one instruction reproduces it
+        if (repro_file.has_value()) {
+            lockstep.replay_reference(divergence->instructions)->write(*repro_file);
+            std::cout << std::format("reproduce with: {} {} --resume {} --instructions 1\n", argv[0], *program_file, *repro_file);
+        }
+        return 1;
+    }
+
+    const uint64_t cases = std::stoull(*random_str);
+    uint64_t seed = seed_str.has_value() ? std::stoull(*seed_str) : 0;
+    const uint64_t length = length_str.has_value() ? std::stoull(*length_str) : 10000;
+    const size_t size = size_str.has_value() ? std::stoul(*size_str, nullptr, 0) : 0x1000;
+    if (size == 0 || size > Machine::IO_ADDRESS) {
+        std::cerr << std::format("Size must be between 1 and {:#x} bytes.", Machine::IO_ADDRESS) << std::endl;
+        return EINVAL;
+    }
+
+    for (uint64_t i = 0; i < cases; ++i, ++seed) {
+        std::vector<uint8_t> bytes = random_bytes(seed, size);
+        lockstep.load(image(bytes));
+        const std::optional<Lockstep::Divergence> divergence = lockstep.run(length);
+        total += lockstep.instructions();
+        if (std::chrono::steady_clock::now() - report >= 1s) {
+            report = std::chrono::steady_clock::now();
+            std::cout << std::format("cases {}, instructions {} ({:.0f}/s)\n", i + 1, total, rate());
+        }
+        if (!divergence.has_value())
+            continue;
+
+        std::cout << std::format("seed {}: ", seed) << divergence->describe();
+        const uint64_t instructions = minimize(lockstep, bytes, length);
+        size_t nonzero = 0;
+        for (const uint8_t byte: bytes)
+            nonzero += byte != 0;
+        std::cout << std::format("minimized to {} nonzero bytes, diverging after {} instructions\n", nonzero, instructions);
+        lockstep.load(image(bytes));
+        std::cout << lockstep.run(length)->describe();
+        if (repro_file.has_value()) {
+            image(bytes).write(*repro_file);
+            std::cout << std::format("reproduce with: {} {} --instructions {}\n", argv[0], *repro_file, instructions + 1);
+        }
+        return 1;
+    }
+    std::cout << std::format("no divergence in {} cases, {} instructions ({:.0f}/s)\n", cases, total, rate());
+}
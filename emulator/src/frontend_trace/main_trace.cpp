@@ -0,0 +1,55 @@
+#include <cstdint>
+#include <format>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "../../inc/emulator/tracer.hpp"
+#include "../../inc/utils/arg_parse.hpp"
+
+// Trace dump frontend: prints a trace written by the headless emulator's --trace, one instruction
+// per line.
+
+static const char* REGISTER_NAMES[16] {
+    "ra.l", "ra.h", "sr", "sp", "fp", "gb", "gc", "gd",
+    "ge.l", "ge.h", "gf.l", "gf.h", "gg.l", "gg.h", "gh.l", "gh.h",
+};
+
+int main(int argc, const char* argv[]) {
+    ArgParse args(argc, argv);
+
+    if (auto error = args.get_error()) {
+        std::cerr << "Error parsing arguments: " << *error << std::endl;
+        return EINVAL;
+    }
+
+    auto limit_str = args.take_option("--limit");
+    auto trace_file = args.take_normal();
+
+    if (args.has_remaining() || !trace_file.has_value()) {
+        std::cerr << "Usage: " << argv[0] << " <trace file> [--limit n]" << std::endl;
+        return EINVAL;
+    }
+
+    const uint64_t limit = limit_str.has_value() ? std::stoull(*limit_str) : UINT64_MAX;
+
+    try {
+        TraceReader reader(*trace_file);
+        Tracer::Record record;
+        for (uint64_t i = 0; i < limit && reader.next(record); ++i) {
+            std::string line = std::format("{:>12} {:04x}: {:04x} sr={:02x}", record.cycle, record.pc, record.instruction, record.sr);
+            if (record.flags & Tracer::REG)
+                line += std::format(" {}={:02x}", REGISTER_NAMES[record.reg & 0x0F], record.reg_value);
+            if (record.flags & Tracer::RA)
+                line += std::format(" ra.l={:02x} ra.h={:02x}", record.ra & 0xFF, record.ra >> 8);
+            if (record.flags & Tracer::READ)
+                line += std::format(" [{:04x}]->{:02x}", record.address, record.mem_value);
+            if (record.flags & Tracer::WRITE)
+                line += std::format(" [{:04x}]<-{:02x}", record.address, record.mem_value);
+            std::cout << line << '\n';
+        }
+    } catch (const std::runtime_error& e) {
+        std::cerr << e.what() << std::endl;
+        return EIO;
+    }
+}
@@ -1,4 +1,5 @@
 #include "../../inc/utils/arg_parse.hpp"
+#include <charconv>
 
 ArgParse::ArgParse(const int argc, const char* argv[]) {
     const char *option_name = NULL;
@@ -38,8 +39,9 @@ std::optional<std::string> ArgParse::take_option(const char *str) {
     auto key = std::string(str);
     auto it = options.find(key);
     if (it != options.end()) {
-        options.erase(key);
-        return it->second;
+        auto value = std::move(it->second);
+        options.erase(it);
+        return value;
     } else {
         return {};
     }
@@ -51,4 +53,15 @@ std::optional<std::string> ArgParse::get_error() {
 
 bool ArgParse::has_remaining() {
     return !(options.empty() && normal_args.empty());
-}
\ No newline at end of file
+}
+
+std::optional<uint64_t> ArgParse::parse_number(const std::string& str) {
+    const bool hex = str.starts_with("0x") || str.starts_with("0X");
+    const char* first = str.data() + (hex ? 2 : 0);
+    const char* last = str.data() + str.size();
+    uint64_t value;
+    const auto [end, error] = std::from_chars(first, last, value, hex ? 16 : 10);
+    if (first == last || error != std::errc() || end != last)
+        return {};
+    return value;
+}